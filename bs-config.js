@@ -0,0 +1,12 @@
+// Dev server settings used by `npm run serve`.
+// Cross-origin isolation enables SharedArrayBuffer, which the threaded CPU fallback (fallback.js) needs.
+// credentialless (rather than require-corp) keeps the CDN stylesheet loading
+module.exports = {
+    middleware: [
+        (req, res, next) => {
+            res.setHeader('Cross-Origin-Opener-Policy', 'same-origin');
+            res.setHeader('Cross-Origin-Embedder-Policy', 'credentialless');
+            next();
+        }
+    ]
+};
@@ -0,0 +1,26 @@
+# Generates a header holding every src/shaders/*.wgsl file as a string literal, so shaders ship
+# inside the binary instead of a virtual filesystem.
+# Usage: cmake -DSHADER_DIR=<dir> -DOUTPUT=<header> -DMINIFY=<ON|OFF> -P EmbedShaders.cmake
+
+file(GLOB shaders "${SHADER_DIR}/*.wgsl")
+list(SORT shaders)
+
+set(content "// Generated by cmake/EmbedShaders.cmake, do not edit\n")
+string(APPEND content "#pragma once\n#include <string_view>\n\n")
+string(APPEND content "struct EmbeddedShader {\n    std::string_view name;\n    const char* source;\n};\n\n")
+string(APPEND content "inline constexpr EmbeddedShader EMBEDDED_SHADERS[] = {\n")
+foreach(shader IN LISTS shaders)
+    file(READ "${shader}" source)
+    if(MINIFY)
+        # WGSL has no string literals, so // always starts a comment
+        string(REGEX REPLACE "//[^\n]*" "" source "${source}")
+        string(REGEX REPLACE "[ \t]+" " " source "${source}")
+        string(REGEX REPLACE "[ \n]*\n[ \n]*" "\n" source "${source}")
+        string(STRIP "${source}" source)
+    endif()
+    get_filename_component(name "${shader}" NAME)
+    string(APPEND content "    { \"${name}\", R\"wgsl(${source})wgsl\" },\n")
+endforeach()
+string(APPEND content "};\n")
+
+file(WRITE "${OUTPUT}" "${content}")
@@ -0,0 +1,139 @@
+#include "Checkpoint.h"
+#include "ZeroRuns.h"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+void Checkpoint::save(const std::string& path, const Info& info, const RowReader& readRow, bool compress, uint32_t tileRows)
+{
+    if (info.width == 0 || info.height == 0) throw CheckpointError("Empty grid");
+    if (tileRows == 0) throw CheckpointError("Tiles need at least one row");
+
+    const uint32_t rowWords = (info.width + 31) / 32;
+    const uint32_t tileCount = (info.height + tileRows - 1) / tileRows;
+    FileHeader header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.width = info.width;
+    header.height = info.height;
+    header.birth = info.rule.birth;
+    header.survival = info.rule.survival;
+    header.boundary = static_cast<uint32_t>(info.boundary);
+    header.tileRows = tileRows;
+    header.generation = info.generation;
+    header.seed = info.seed;
+    header.tileCount = tileCount;
+
+    const std::string temporaryPath = path + ".tmp";
+    std::ofstream stream(temporaryPath, std::ios::binary | std::ios::trunc);
+    if (!stream) throw CheckpointError("Failed to create " + temporaryPath);
+
+    // The tile table is only known once every tile is written, so it is filled in at the end
+    std::vector<TileEntry> entries(tileCount);
+    uint64_t offset = sizeof(FileHeader) + entries.size() * sizeof(TileEntry);
+    stream.seekp(static_cast<std::streamoff>(offset));
+
+    std::vector<uint32_t> tile(static_cast<size_t>(tileRows) * rowWords);
+    std::vector<uint32_t> compressed;
+    for (uint32_t i = 0; i < tileCount; ++i) {
+        const uint32_t firstRow = i * tileRows;
+        const uint32_t rowCount = std::min(tileRows, info.height - firstRow);
+        const size_t wordCount = static_cast<size_t>(rowCount) * rowWords;
+        for (uint32_t row = 0; row < rowCount; ++row) readRow(firstRow + row, tile.data() + static_cast<size_t>(row) * rowWords);
+
+        const uint32_t* stored = tile.data();
+        size_t storedCount = wordCount;
+        entries[i].encoding = Encoding::Raw;
+        if (compress) {
+            ZeroRuns::compress(tile.data(), wordCount, compressed);
+            if (compressed.size() < wordCount) {
+                stored = compressed.data();
+                storedCount = compressed.size();
+                entries[i].encoding = Encoding::ZeroRuns;
+            }
+        }
+        entries[i].offset = offset;
+        entries[i].wordCount = static_cast<uint32_t>(storedCount);
+        stream.write(reinterpret_cast<const char*>(stored), static_cast<std::streamsize>(storedCount * sizeof(uint32_t)));
+        offset += storedCount * sizeof(uint32_t);
+    }
+
+    stream.seekp(0);
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    stream.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(TileEntry)));
+    stream.close();
+    if (!stream) throw CheckpointError("Failed to write " + temporaryPath);
+
+    std::error_code error;
+    std::filesystem::rename(temporaryPath, path, error);
+    if (error) throw CheckpointError("Failed to replace " + path + ": " + error.message());
+}
+
+Checkpoint::Checkpoint(const std::string& path)
+    // Partial loads only fault in the tiles they read
+    : file(std::make_unique<MappedFile>(path, false))
+{
+    FileHeader header {};
+    if (file->size() < sizeof(header)) throw CheckpointError(path + " is too short for a checkpoint");
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) throw CheckpointError(path + " is not a checkpoint");
+    if (header.version != VERSION) {
+        throw CheckpointError(path + " has version " + std::to_string(header.version) + ", expected " + std::to_string(VERSION));
+    }
+    if (header.width == 0 || header.height == 0 || header.tileRows == 0
+        || header.tileCount != (header.height + header.tileRows - 1) / header.tileRows
+        || header.boundary > static_cast<uint32_t>(Boundary::Dead)) {
+        throw CheckpointError(path + " has a malformed header");
+    }
+
+    info.width = header.width;
+    info.height = header.height;
+    info.rule.birth = header.birth;
+    info.rule.survival = header.survival;
+    info.boundary = static_cast<Boundary>(header.boundary);
+    info.generation = header.generation;
+    info.seed = header.seed;
+    wordsPerRow = (header.width + 31) / 32;
+    tileRows = header.tileRows;
+
+    tiles.resize(header.tileCount);
+    const uint64_t tableEnd = sizeof(header) + tiles.size() * sizeof(TileEntry);
+    if (file->size() < tableEnd) throw CheckpointError(path + " is truncated");
+    std::memcpy(tiles.data(), file->data() + sizeof(header), tiles.size() * sizeof(TileEntry));
+    for (const TileEntry& tile : tiles) {
+        if (tile.offset < tableEnd || tile.offset % sizeof(uint32_t) != 0
+            || tile.offset + static_cast<uint64_t>(tile.wordCount) * sizeof(uint32_t) > file->size()
+            || (tile.encoding != Encoding::Raw && tile.encoding != Encoding::ZeroRuns)) {
+            throw CheckpointError(path + " has a malformed tile table");
+        }
+    }
+}
+
+void Checkpoint::readRows(uint32_t firstRow, uint32_t endRow, const TileVisitor& visit) const
+{
+    endRow = std::min(endRow, info.height);
+    std::vector<uint32_t> scratch;
+    for (uint32_t i = firstRow / tileRows; firstRow < endRow; ++i) {
+        const TileEntry& tile = tiles[i];
+        const uint32_t tileFirstRow = i * tileRows;
+        const uint32_t tileRowCount = std::min(tileRows, info.height - tileFirstRow);
+        const size_t wordCount = static_cast<size_t>(tileRowCount) * wordsPerRow;
+        const auto* stored = reinterpret_cast<const uint32_t*>(file->data() + tile.offset);
+
+        const uint32_t* words = stored;
+        if (tile.encoding == Encoding::Raw) {
+            if (tile.wordCount != wordCount) throw CheckpointError("Tile " + std::to_string(i) + " has the wrong size");
+        } else {
+            scratch.resize(wordCount);
+            if (!ZeroRuns::expand(stored, tile.wordCount, scratch.data(), wordCount)) {
+                throw CheckpointError("Tile " + std::to_string(i) + " is corrupt");
+            }
+            words = scratch.data();
+        }
+
+        const uint32_t rowEnd = std::min(endRow, tileFirstRow + tileRowCount);
+        visit(firstRow, rowEnd - firstRow, words + static_cast<size_t>(firstRow - tileFirstRow) * wordsPerRow);
+        firstRow = rowEnd;
+    }
+}
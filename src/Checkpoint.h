@@ -0,0 +1,92 @@
+#pragma once
+#include "MappedFile.h"
+#include "Simulation.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Saved grid state that long runs resume from instead of re-simulating from generation 0.
+// A small header (dimensions, rule, boundary, generation and seed) and a tile table are followed by the
+// cells, bitpacked like CpuLife and Life::Packing::Bits (bit i of word w is cell w * 32 + i) in grid row
+// order, y = 0 first. Rows are grouped into tiles of tileRows rows that are stored either as they are or
+// with runs of empty words squeezed out (ZeroRuns), whichever is smaller, and every tile decodes on its own.
+// The file is memory mapped, so restoring uncompressed tiles hands the mapped pages straight to the
+// GPU upload or the CPU engine's rows. Little-endian hosts only (x86, ARM, wasm)
+class Checkpoint
+{
+public:
+    class CheckpointError : public std::runtime_error {
+        public:
+            CheckpointError(const std::string& msg)
+                : std::runtime_error("Checkpoint failed: " + msg) {}
+    };
+
+    struct Info {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        Rule rule {};
+        Boundary boundary = Boundary::Torus;
+        uint64_t generation = 0;
+        uint64_t seed = 0;
+    };
+
+    static constexpr uint32_t DEFAULT_TILE_ROWS = 256;
+
+    // Fills the bitpacked row y ((width + 31) / 32 words), rows are requested in order
+    using RowReader = std::function<void(uint32_t y, uint32_t* words)>;
+    // Writes to a temporary file next to path and renames it over path once complete, so a crash
+    // mid-save never destroys the previous checkpoint
+    static void save(const std::string& path, const Info& info, const RowReader& readRow,
+                     bool compress = true, uint32_t tileRows = DEFAULT_TILE_ROWS);
+
+    // Maps the file and validates the header and tile table, tiles are decoded on demand
+    explicit Checkpoint(const std::string& path);
+
+    const Info& getInfo() const { return info; }
+    uint32_t getWordsPerRow() const { return wordsPerRow; }
+    uint32_t getTileRows() const { return tileRows; }
+    uint32_t getTileCount() const { return static_cast<uint32_t>(tiles.size()); }
+
+    // Calls visit for the rows [firstRow, endRow) a tile at a time, rows contiguous with getWordsPerRow()
+    // words each. Uncompressed tiles point into the mapping, others are decoded into a scratch buffer
+    // that is only valid during the call. Only the tiles overlapping the range are touched, and
+    // concurrent calls are safe
+    using TileVisitor = std::function<void(uint32_t firstRow, uint32_t rowCount, const uint32_t* words)>;
+    void readRows(uint32_t firstRow, uint32_t endRow, const TileVisitor& visit) const;
+
+private:
+    // On-disk layout, see save()
+    static constexpr char MAGIC[8] = { 'L', 'I', 'F', 'E', 'C', 'K', 'P', 'T' };
+    static constexpr uint32_t VERSION = 1;
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint16_t birth;
+        uint16_t survival;
+        uint32_t boundary;
+        uint32_t tileRows;
+        uint64_t generation;
+        uint64_t seed;
+        uint32_t tileCount;
+        uint32_t reserved;
+    };
+    static_assert(sizeof(FileHeader) == 56, "FileHeader is written as it is");
+    enum class Encoding : uint32_t { Raw = 0, ZeroRuns = 1 };
+    struct TileEntry {
+        uint64_t offset;     // From the start of the file, word aligned
+        uint32_t wordCount;  // Stored words
+        Encoding encoding;
+    };
+    static_assert(sizeof(TileEntry) == 16, "TileEntry is written as it is");
+
+    std::unique_ptr<MappedFile> file;
+    Info info;
+    uint32_t wordsPerRow = 0;
+    uint32_t tileRows = 0;
+    std::vector<TileEntry> tiles;
+};
@@ -0,0 +1,322 @@
+#include "CpuLife.h"
+#include "Random.h"
+#include "Simd.h"
+#include <algorithm>
+#include <bit>
+#include <cstring>
+
+namespace {
+
+// All ones when bit n of mask is set
+constexpr uint32_t ruleBits(uint32_t mask, uint32_t n)
+{
+    return 0u - ((mask >> n) & 1u);
+}
+
+// Steps the word(s) at x, the same full adder network as the PACKED_BITS kernel in shader.wgsl.
+// Row pointers have readable halo words at x - 1 and x + 1
+template <typename Word>
+Word stepWords(const uint32_t* above, const uint32_t* middle, const uint32_t* below, const Rule& rule)
+{
+    const Word center = loadWords<Word>(middle);
+    const Word n0 = (loadWords<Word>(above) << 1) | (loadWords<Word>(above - 1) >> 31);
+    const Word n1 = loadWords<Word>(above);
+    const Word n2 = (loadWords<Word>(above) >> 1) | (loadWords<Word>(above + 1) << 31);
+    const Word n3 = (center << 1) | (loadWords<Word>(middle - 1) >> 31);
+    const Word n4 = (center >> 1) | (loadWords<Word>(middle + 1) << 31);
+    const Word n5 = (loadWords<Word>(below) << 1) | (loadWords<Word>(below - 1) >> 31);
+    const Word n6 = loadWords<Word>(below);
+    const Word n7 = (loadWords<Word>(below) >> 1) | (loadWords<Word>(below + 1) << 31);
+
+    const Word sumA = n0 ^ n1 ^ n2;
+    const Word carryA = (n0 & n1) | (n2 & (n0 ^ n1));
+    const Word sumB = n3 ^ n4 ^ n5;
+    const Word carryB = (n3 & n4) | (n5 & (n3 ^ n4));
+    const Word sumC = n6 ^ n7;
+    const Word carryC = n6 & n7;
+
+    const Word bit0 = sumA ^ sumB ^ sumC;
+    const Word carryD = (sumA & sumB) | (sumC & (sumA ^ sumB));
+
+    const Word sumE = carryA ^ carryB ^ carryC;
+    const Word carryE = (carryA & carryB) | (carryC & (carryA ^ carryB));
+    const Word bit1 = sumE ^ carryD;
+    const Word carryF = sumE & carryD;
+
+    const Word bit2 = carryE ^ carryF;
+    const Word bit3 = carryE & carryF;
+
+    // Only counts that appear in the rule can produce an active cell
+    Word next = center ^ center;
+    const uint32_t counts = rule.birth | rule.survival;
+    for (uint32_t n = 0; n <= 8; ++n) {
+        if (!(counts & (1u << n))) continue;
+        const Word equals = ~(bit0 ^ ruleBits(n, 0)) & ~(bit1 ^ ruleBits(n, 1)) &
+                            ~(bit2 ^ ruleBits(n, 2)) & ~(bit3 ^ ruleBits(n, 3));
+        next |= equals & ((center & ruleBits(rule.survival, n)) | (~center & ruleBits(rule.birth, n)));
+    }
+    return next;
+}
+
+} // namespace
+
+CpuLife::CpuLife(const Config& config)
+    : config(config)
+    , wordsPerRow(config.width / 32)
+    , stride(config.width / 32 + 2)
+{
+    if (config.width == 0 || config.width % 32 != 0) {
+        throw CpuLife::InitializationError("Grid width must be a positive multiple of 32");
+    }
+    if (config.height == 0) throw CpuLife::InitializationError("Grid height must be positive");
+
+    const size_t size = static_cast<size_t>(stride) * (config.height + 2);
+    current.assign(size, 0);
+    next.assign(size, 0);
+
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    // The single-threaded browser build (fallback-single.js) can't start threads
+    const unsigned threads = 1;
+#else
+    const unsigned threads = std::max(1u, config.threads);
+#endif
+    for (unsigned band = 1; band < threads; ++band) {
+        workers.emplace_back(&CpuLife::workerLoop, this, band);
+    }
+}
+
+CpuLife::~CpuLife()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void CpuLife::randomize(uint64_t seed, float density)
+{
+    // Counter-based, so bands fill in parallel and the soup matches the GPU seeding pass exactly
+    const uint32_t threshold = Random::densityThreshold(density);
+    runBands([this, seed, threshold](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) Random::fillCells(seed, y, 0, wordsPerRow, threshold, row(current, y));
+    });
+    generation = 0;
+}
+
+void CpuLife::load(const Pattern& pattern, uint32_t x, uint32_t y)
+{
+    runBands([this, &pattern, x, y](uint32_t begin, uint32_t end) {
+        for (uint32_t gridY = begin; gridY < end; ++gridY) {
+            uint32_t* words = row(current, gridY);
+            std::fill(words, words + wordsPerRow, 0u);
+            if (gridY >= y && gridY - y < pattern.getHeight()) {
+                pattern.blitRow(pattern.getHeight() - 1 - (gridY - y), x, words, config.width);
+            }
+        }
+    });
+    generation = 0;
+}
+
+void CpuLife::restore(const Checkpoint& checkpoint)
+{
+    const Checkpoint::Info& info = checkpoint.getInfo();
+    if (info.width != config.width || info.height != config.height) {
+        throw InitializationError("Checkpoint is " + std::to_string(info.width) + "x" + std::to_string(info.height)
+            + ", the grid " + std::to_string(config.width) + "x" + std::to_string(config.height));
+    }
+    // Tiles decode independently, so every band reads only its own rows
+    runBands([this, &checkpoint](uint32_t begin, uint32_t end) {
+        checkpoint.readRows(begin, end, [this](uint32_t firstRow, uint32_t rowCount, const uint32_t* words) {
+            for (uint32_t y = 0; y < rowCount; ++y) {
+                std::memcpy(row(current, firstRow + y), words + static_cast<size_t>(y) * wordsPerRow, wordsPerRow * sizeof(uint32_t));
+            }
+        });
+    });
+    generation = info.generation;
+}
+
+void CpuLife::save(const std::string& path, uint64_t seed, bool compress) const
+{
+    Checkpoint::Info info;
+    info.width = config.width;
+    info.height = config.height;
+    info.rule = config.rule;
+    info.boundary = config.boundary;
+    info.generation = generation;
+    info.seed = seed;
+    Checkpoint::save(path, info, [this](uint32_t y, uint32_t* words) {
+        std::memcpy(words, row(current, y), wordsPerRow * sizeof(uint32_t));
+    }, compress);
+}
+
+void CpuLife::copyCells(uint32_t* words) const
+{
+    for (uint32_t y = 0; y < config.height; ++y) {
+        std::memcpy(words + static_cast<size_t>(y) * wordsPerRow, row(current, y), wordsPerRow * sizeof(uint32_t));
+    }
+}
+
+void CpuLife::setCells(const uint32_t* words, uint64_t generation)
+{
+    for (uint32_t y = 0; y < config.height; ++y) {
+        std::memcpy(row(current, y), words + static_cast<size_t>(y) * wordsPerRow, wordsPerRow * sizeof(uint32_t));
+    }
+    this->generation = generation;
+}
+
+void CpuLife::step(uint32_t generations)
+{
+    for (uint32_t i = 0; i < generations; ++i) {
+        fillHalo();
+        runBands([this](uint32_t begin, uint32_t end) { stepRows(begin, end); });
+        std::swap(current, next);
+        ++generation;
+    }
+}
+
+void CpuLife::fillHalo()
+{
+    const bool torus = config.boundary == Boundary::Torus;
+    for (uint32_t y = 0; y < config.height; ++y) {
+        uint32_t* words = row(current, y);
+        words[-1] = torus ? words[wordsPerRow - 1] : 0;
+        words[wordsPerRow] = torus ? words[0] : 0;
+    }
+
+    // Whole padded rows, so the corners wrap diagonally on a torus
+    uint32_t* top = row(current, -1) - 1;
+    uint32_t* bottom = row(current, config.height) - 1;
+    if (torus) {
+        std::memcpy(top, row(current, config.height - 1) - 1, stride * sizeof(uint32_t));
+        std::memcpy(bottom, row(current, 0) - 1, stride * sizeof(uint32_t));
+    } else {
+        std::fill(top, top + stride, 0u);
+        std::fill(bottom, bottom + stride, 0u);
+    }
+}
+
+void CpuLife::stepRows(uint32_t begin, uint32_t end)
+{
+    const Rule rule = config.rule;
+    for (uint32_t y = begin; y < end; ++y) {
+        const uint32_t* above = row(current, static_cast<int32_t>(y) - 1);
+        const uint32_t* middle = row(current, y);
+        const uint32_t* below = row(current, y + 1);
+        uint32_t* out = row(next, y);
+
+        uint32_t x = 0;
+        if (config.kernel == Kernel::Vector) {
+            for (; x + VECTOR_WORDS <= wordsPerRow; x += VECTOR_WORDS) {
+                storeWords(out + x, stepWords<WordVector>(above + x, middle + x, below + x, rule));
+            }
+        }
+        for (; x < wordsPerRow; ++x) {
+            out[x] = stepWords<uint32_t>(above + x, middle + x, below + x, rule);
+        }
+    }
+}
+
+void CpuLife::render(std::vector<uint8_t>& rgba)
+{
+    rgba.resize(static_cast<size_t>(config.width) * config.height * 4);
+    runBands([this, &rgba](uint32_t begin, uint32_t end) { renderRows(rgba.data(), begin, end); });
+}
+
+void CpuLife::renderRows(uint8_t* rgba, uint32_t begin, uint32_t end) const
+{
+    // Same palette as shader.wgsl, a gradient over the grid on the clear color. Grid y points up
+    // like clip space, so the top image row shows the last grid row
+    constexpr uint8_t BACKGROUND[4] = { 0, 0, 102, 255 };
+    const float width = static_cast<float>(config.width);
+    const float height = static_cast<float>(config.height);
+    for (uint32_t y = begin; y < end; ++y) {
+        const uint32_t* words = row(current, y);
+        uint8_t* pixel = rgba + static_cast<size_t>(config.height - 1 - y) * config.width * 4;
+        const uint8_t green = static_cast<uint8_t>(y / height * 255.0f);
+        for (uint32_t x = 0; x < config.width; ++x, pixel += 4) {
+            if ((words[x / 32] >> (x % 32)) & 1u) {
+                const float red = x / width;
+                pixel[0] = static_cast<uint8_t>(red * 255.0f);
+                pixel[1] = green;
+                pixel[2] = static_cast<uint8_t>((1.0f - red) * 255.0f);
+                pixel[3] = 255;
+            } else {
+                std::memcpy(pixel, BACKGROUND, 4);
+            }
+        }
+    }
+}
+
+bool CpuLife::getCell(uint32_t x, uint32_t y) const
+{
+    return (row(current, y)[x / 32] >> (x % 32)) & 1u;
+}
+
+void CpuLife::setCell(uint32_t x, uint32_t y, bool active)
+{
+    uint32_t& word = row(current, y)[x / 32];
+    const uint32_t bit = 1u << (x % 32);
+    word = active ? word | bit : word & ~bit;
+}
+
+uint64_t CpuLife::getPopulation() const
+{
+    uint64_t population = 0;
+    for (uint32_t y = 0; y < config.height; ++y) {
+        const uint32_t* words = row(current, y);
+        for (uint32_t x = 0; x < wordsPerRow; ++x) population += std::popcount(words[x]);
+    }
+    return population;
+}
+
+void CpuLife::bandRange(unsigned band, uint32_t& begin, uint32_t& end) const
+{
+    const uint64_t bands = workers.size() + 1;
+    begin = static_cast<uint32_t>(config.height * band / bands);
+    end = static_cast<uint32_t>(config.height * (band + 1) / bands);
+}
+
+void CpuLife::runBands(const std::function<void(uint32_t, uint32_t)>& work)
+{
+    if (!workers.empty()) {
+        std::lock_guard<std::mutex> lock(mutex);
+        task = work;
+        pendingBands = static_cast<unsigned>(workers.size());
+        ++taskSerial;
+    }
+    workAvailable.notify_all();
+
+    // The calling thread takes band 0 instead of idling
+    uint32_t begin, end;
+    bandRange(0, begin, end);
+    work(begin, end);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workDone.wait(lock, [this] { return pendingBands == 0; });
+}
+
+void CpuLife::workerLoop(unsigned band)
+{
+    uint64_t seenSerial = 0;
+    while (true) {
+        std::function<void(uint32_t, uint32_t)> work;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [&] { return stopping || taskSerial != seenSerial; });
+            if (stopping) return;
+            seenSerial = taskSerial;
+            work = task;
+        }
+
+        uint32_t begin, end;
+        bandRange(band, begin, end);
+        work(begin, end);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (--pendingBands == 0) workDone.notify_one();
+        }
+    }
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include "Checkpoint.h"
+#include "Pattern.h"
+#include "Simulation.h"
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// CPU engine for machines (and browsers) without WebGPU.
+// Cells are bitpacked like Life::Packing::Bits, 32 cells per word along x with bit i of word w
+// holding cell w * 32 + i, and stepped with the same bit-sliced neighbor count as shader.wgsl.
+// Words are processed with portable vector types, so wasm builds with -msimd128 handle four words
+// per instruction, and row bands are split across a pool of worker threads.
+class CpuLife
+{
+public:
+    // Vector steps four words per operation, Swar32 one 32-bit word (32 cells, the baseline it is measured against)
+    enum class Kernel { Vector, Swar32 };
+
+    struct Config {
+        uint32_t width = 1024;  // Must be a multiple of 32
+        uint32_t height = 1024;
+        Rule rule {};
+        Boundary boundary = Boundary::Torus;
+        unsigned threads = std::thread::hardware_concurrency(); // Including the calling thread
+        Kernel kernel = Kernel::Vector;
+    };
+
+    class InitializationError : public std::runtime_error {
+        public:
+            InitializationError(const std::string& msg)
+                : std::runtime_error("Initialization failed: " + msg) {}
+    };
+
+    explicit CpuLife(const Config& config);
+    ~CpuLife();
+    CpuLife(const CpuLife&) = delete;
+    CpuLife& operator=(const CpuLife&) = delete;
+
+    // Fills the grid with random cells, the same ones Life::seed produces for this seed and density
+    void randomize(uint64_t seed, float density = 0.5f);
+    // Clears the grid and places the pattern with the bottom left of its bounding box at (x, y),
+    // clipped to the grid. Pattern rows run top down, so its first row lands on the highest grid row
+    void load(const Pattern& pattern, uint32_t x, uint32_t y);
+    // Continues from a checkpoint of the same size, including its generation count. Rule and
+    // boundary come from Config, which should be set from the checkpoint's Info
+    void restore(const Checkpoint& checkpoint);
+    // seed is recorded for reference only, the grid itself is saved
+    void save(const std::string& path, uint64_t seed, bool compress = true) const;
+    // The grid as height rows of width / 32 words without the halo, like Checkpoint and Recorder
+    void copyCells(uint32_t* words) const;
+    void setCells(const uint32_t* words, uint64_t generation);
+    void step(uint32_t generations = 1);
+    // Draws one pixel per cell with the same colors as the WebGPU renderer, rgba is resized to fit
+    void render(std::vector<uint8_t>& rgba);
+
+    bool getCell(uint32_t x, uint32_t y) const;
+    void setCell(uint32_t x, uint32_t y, bool active);
+    uint64_t getPopulation() const;
+    uint64_t getGeneration() const { return generation; }
+    uint32_t getWidth() const { return config.width; }
+    uint32_t getHeight() const { return config.height; }
+    unsigned getThreadCount() const { return static_cast<unsigned>(workers.size()) + 1; }
+
+private:
+    Config config;
+    uint32_t wordsPerRow;
+    // Rows are padded by a halo word on both sides and a halo row above and below, refreshed from
+    // the boundary before every step, so the kernel never branches on edges
+    uint32_t stride;
+    std::vector<uint32_t> current;
+    std::vector<uint32_t> next;
+    uint64_t generation = 0;
+
+    // Worker pool, runBands splits rows [0, height) into one band per thread and waits for all of them
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable workDone;
+    std::function<void(uint32_t, uint32_t)> task;
+    uint64_t taskSerial = 0;
+    unsigned pendingBands = 0;
+    bool stopping = false;
+
+    uint32_t* row(std::vector<uint32_t>& cells, int32_t y) { return cells.data() + (y + 1) * stride + 1; }
+    const uint32_t* row(const std::vector<uint32_t>& cells, int32_t y) const { return cells.data() + (y + 1) * stride + 1; }
+    void fillHalo();
+    void stepRows(uint32_t begin, uint32_t end);
+    void renderRows(uint8_t* rgba, uint32_t begin, uint32_t end) const;
+    void runBands(const std::function<void(uint32_t, uint32_t)>& work);
+    void bandRange(unsigned band, uint32_t& begin, uint32_t& end) const;
+    void workerLoop(unsigned band);
+};
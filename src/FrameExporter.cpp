@@ -0,0 +1,259 @@
+#include "FrameExporter.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <filesystem>
+
+namespace {
+
+void appendU32BigEndian(std::vector<uint8_t>& out, uint32_t value)
+{
+    out.push_back(static_cast<uint8_t>(value >> 24));
+    out.push_back(static_cast<uint8_t>(value >> 16));
+    out.push_back(static_cast<uint8_t>(value >> 8));
+    out.push_back(static_cast<uint8_t>(value));
+}
+
+uint32_t crc32(const uint8_t* data, size_t size)
+{
+    static const std::array<uint32_t, 256> table = [] {
+        std::array<uint32_t, 256> result {};
+        for (uint32_t n = 0; n < 256; ++n) {
+            uint32_t c = n;
+            for (int k = 0; k < 8; ++k) {
+                c = (c & 1) ? 0xEDB88320u ^ (c >> 1) : c >> 1;
+            }
+            result[n] = c;
+        }
+        return result;
+    }();
+
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < size; ++i) {
+        crc = table[(crc ^ data[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+void appendPngChunk(std::vector<uint8_t>& out, const char type[4], const std::vector<uint8_t>& data)
+{
+    appendU32BigEndian(out, static_cast<uint32_t>(data.size()));
+    const size_t typeOffset = out.size();
+    out.insert(out.end(), type, type + 4);
+    out.insert(out.end(), data.begin(), data.end());
+    appendU32BigEndian(out, crc32(out.data() + typeOffset, out.size() - typeOffset));
+}
+
+} // namespace
+
+FrameExporter::FrameExporter(Format format, const std::string& outputPath,
+                             unsigned threadCount, size_t maxQueuedFrames)
+    : format(format)
+    , outputPath(outputPath)
+    , maxQueuedFrames(std::max<size_t>(1, maxQueuedFrames))
+{
+    if (format == Format::Y4m) {
+        stream.open(outputPath, std::ios::binary | std::ios::trunc);
+        if (!stream.is_open()) throw ExportError("Failed to open " + outputPath);
+    } else {
+        std::error_code ec;
+        std::filesystem::create_directories(outputPath, ec);
+        if (ec) throw ExportError("Failed to create directory " + outputPath + ": " + ec.message());
+    }
+
+    threadCount = std::max(1u, threadCount);
+    for (unsigned i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&FrameExporter::workerLoop, this);
+    }
+}
+
+FrameExporter::~FrameExporter()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+void FrameExporter::submit(Frame&& frame)
+{
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (error) std::rethrow_exception(error);
+        spaceAvailable.wait(lock, [this] { return pending.size() < maxQueuedFrames; });
+        pending.emplace(nextSequence++, std::move(frame));
+    }
+    workAvailable.notify_one();
+}
+
+void FrameExporter::finish()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending.empty() && activeWorkers == 0; });
+    if (stream.is_open()) stream.flush();
+    if (error) std::rethrow_exception(error);
+}
+
+uint64_t FrameExporter::getFramesWritten() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return framesWritten;
+}
+
+void FrameExporter::workerLoop()
+{
+    while (true) {
+        std::pair<uint64_t, Frame> job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this] { return stopping || !pending.empty(); });
+            // Only exit once the queue is drained, so destruction never loses submitted frames
+            if (pending.empty()) return;
+            job = std::move(pending.front());
+            pending.pop();
+            ++activeWorkers;
+        }
+        spaceAvailable.notify_one();
+
+        try {
+            exportFrame(job.first, job.second);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            --activeWorkers;
+            if (pending.empty() && activeWorkers == 0) idle.notify_all();
+        }
+    }
+}
+
+void FrameExporter::exportFrame(uint64_t sequence, const Frame& frame)
+{
+    if (frame.rgba.size() != static_cast<size_t>(frame.width) * frame.height * 4) {
+        throw ExportError("Frame " + std::to_string(frame.index) + " has mismatched pixel data");
+    }
+
+    if (format == Format::Y4m) {
+        writeInOrder(sequence, frame, encodeY4mFrame(frame));
+        return;
+    }
+
+    // Png frames are independent files, no ordering needed
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%08llu.png", static_cast<unsigned long long>(frame.index));
+    const std::filesystem::path path = std::filesystem::path(outputPath) / name;
+
+    const std::vector<uint8_t> png = encodePng(frame);
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file.is_open()) throw ExportError("Failed to open " + path.string());
+    file.write(reinterpret_cast<const char*>(png.data()), static_cast<std::streamsize>(png.size()));
+    if (!file) throw ExportError("Failed to write " + path.string());
+
+    std::lock_guard<std::mutex> lock(mutex);
+    ++framesWritten;
+}
+
+void FrameExporter::writeInOrder(uint64_t sequence, const Frame& frame, std::vector<uint8_t>&& bytes)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    encodedFrames.emplace(sequence, std::move(bytes));
+
+    if (!streamHeaderWritten && sequence == 0) {
+        // Stream dimensions come from the first frame, all later frames must match them
+        stream << "YUV4MPEG2 W" << frame.width << " H" << frame.height << " F30:1 Ip A1:1 C444\n";
+        streamHeaderWritten = true;
+    }
+
+    // Flush every frame that is now contiguous with what was already written
+    for (auto it = encodedFrames.find(nextSequenceToWrite);
+         streamHeaderWritten && it != encodedFrames.end();
+         it = encodedFrames.find(nextSequenceToWrite)) {
+        stream << "FRAME\n";
+        stream.write(reinterpret_cast<const char*>(it->second.data()), static_cast<std::streamsize>(it->second.size()));
+        encodedFrames.erase(it);
+        ++nextSequenceToWrite;
+        ++framesWritten;
+    }
+    if (!stream) throw ExportError("Failed to write " + outputPath);
+}
+
+std::vector<uint8_t> FrameExporter::encodePng(const Frame& frame)
+{
+    // Each row is prefixed by filter type 0 (None)
+    const size_t rowBytes = static_cast<size_t>(frame.width) * 4;
+    std::vector<uint8_t> raw;
+    raw.reserve((rowBytes + 1) * frame.height);
+    for (uint32_t y = 0; y < frame.height; ++y) {
+        raw.push_back(0);
+        const uint8_t* row = frame.rgba.data() + y * rowBytes;
+        raw.insert(raw.end(), row, row + rowBytes);
+    }
+
+    // zlib stream made of stored (uncompressed) deflate blocks. Encoding stays memory bound so
+    // the pool keeps pace with the simulation, the output is meant to be re-encoded to video anyway
+    constexpr size_t MAX_STORED_BLOCK = 65535;
+    std::vector<uint8_t> idat;
+    idat.reserve(raw.size() + raw.size() / MAX_STORED_BLOCK * 5 + 16);
+    idat.push_back(0x78); // CMF: deflate, 32K window
+    idat.push_back(0x01); // FLG: no dictionary, fastest, (CMF * 256 + FLG) % 31 == 0
+    size_t offset = 0;
+    do {
+        const size_t blockSize = std::min(MAX_STORED_BLOCK, raw.size() - offset);
+        const bool lastBlock = offset + blockSize == raw.size();
+        idat.push_back(lastBlock ? 1 : 0);
+        idat.push_back(static_cast<uint8_t>(blockSize));
+        idat.push_back(static_cast<uint8_t>(blockSize >> 8));
+        idat.push_back(static_cast<uint8_t>(~blockSize));
+        idat.push_back(static_cast<uint8_t>(~blockSize >> 8));
+        idat.insert(idat.end(), raw.begin() + offset, raw.begin() + offset + blockSize);
+        offset += blockSize;
+    } while (offset < raw.size());
+
+    uint32_t a = 1, b = 0;
+    constexpr uint32_t ADLER_MOD = 65521;
+    for (uint8_t byte : raw) {
+        a = (a + byte) % ADLER_MOD;
+        b = (b + a) % ADLER_MOD;
+    }
+    appendU32BigEndian(idat, (b << 16) | a);
+
+    std::vector<uint8_t> ihdr;
+    appendU32BigEndian(ihdr, frame.width);
+    appendU32BigEndian(ihdr, frame.height);
+    ihdr.push_back(8); // Bit depth
+    ihdr.push_back(6); // Color type RGBA
+    ihdr.push_back(0); // Compression
+    ihdr.push_back(0); // Filter
+    ihdr.push_back(0); // Interlace
+
+    std::vector<uint8_t> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+    png.reserve(idat.size() + 64);
+    appendPngChunk(png, "IHDR", ihdr);
+    appendPngChunk(png, "IDAT", idat);
+    appendPngChunk(png, "IEND", {});
+    return png;
+}
+
+std::vector<uint8_t> FrameExporter::encodeY4mFrame(const Frame& frame)
+{
+    // BT.601 studio swing, planar Y then U then V at full resolution
+    const size_t pixelCount = static_cast<size_t>(frame.width) * frame.height;
+    std::vector<uint8_t> yuv(pixelCount * 3);
+    uint8_t* yPlane = yuv.data();
+    uint8_t* uPlane = yPlane + pixelCount;
+    uint8_t* vPlane = uPlane + pixelCount;
+    for (size_t i = 0; i < pixelCount; ++i) {
+        const int r = frame.rgba[i * 4 + 0];
+        const int g = frame.rgba[i * 4 + 1];
+        const int b = frame.rgba[i * 4 + 2];
+        yPlane[i] = static_cast<uint8_t>(((66 * r + 129 * g + 25 * b + 128) >> 8) + 16);
+        uPlane[i] = static_cast<uint8_t>(((-38 * r - 74 * g + 112 * b + 128) >> 8) + 128);
+        vPlane[i] = static_cast<uint8_t>(((112 * r - 94 * g - 18 * b + 128) >> 8) + 128);
+    }
+    return yuv;
+}
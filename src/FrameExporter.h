@@ -0,0 +1,75 @@
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Encodes rendered frames on a pool of worker threads.
+// Png writes one numbered file per frame into a directory, Y4m appends every frame to a single
+// 4:4:4 YUV4MPEG2 stream (frames are encoded in parallel and written back in submission order).
+class FrameExporter
+{
+public:
+    enum class Format { Png, Y4m };
+
+    struct Frame {
+        uint64_t index = 0;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::vector<uint8_t> rgba; // Tightly packed rows, 4 bytes per pixel
+    };
+
+    class ExportError : public std::runtime_error {
+        public:
+            ExportError(const std::string& msg)
+                : std::runtime_error("Frame export failed: " + msg) {}
+    };
+
+    FrameExporter(Format format, const std::string& outputPath,
+                  unsigned threadCount = std::thread::hardware_concurrency(),
+                  size_t maxQueuedFrames = 16);
+    ~FrameExporter();
+
+    // Queues a frame for encoding, blocks only while maxQueuedFrames are already waiting
+    void submit(Frame&& frame);
+    // Waits for every queued frame to be written, rethrows the first worker error
+    void finish();
+    uint64_t getFramesWritten() const;
+
+private:
+    Format format;
+    std::string outputPath;
+    std::ofstream stream; // Y4m output
+    size_t maxQueuedFrames;
+
+    std::vector<std::thread> workers;
+    std::queue<std::pair<uint64_t, Frame>> pending; // Submission sequence number, frame
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable spaceAvailable;
+    std::condition_variable idle;
+    size_t activeWorkers = 0;
+    bool stopping = false;
+    std::exception_ptr error;
+
+    // Y4m reordering, encoded frames wait here until every earlier frame is written
+    std::map<uint64_t, std::vector<uint8_t>> encodedFrames;
+    uint64_t nextSequence = 0;
+    uint64_t nextSequenceToWrite = 0;
+    bool streamHeaderWritten = false;
+    uint64_t framesWritten = 0;
+
+    void workerLoop();
+    void exportFrame(uint64_t sequence, const Frame& frame);
+    void writeInOrder(uint64_t sequence, const Frame& frame, std::vector<uint8_t>&& bytes);
+    static std::vector<uint8_t> encodePng(const Frame& frame);
+    static std::vector<uint8_t> encodeY4mFrame(const Frame& frame);
+};
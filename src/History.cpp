@@ -0,0 +1,84 @@
+#include "History.h"
+#include "ZeroRuns.h"
+
+History::History(size_t memoryBudget)
+    : memoryBudget(memoryBudget)
+{
+}
+
+void History::clear()
+{
+    changes.clear();
+    memoryUsage = 0;
+    grid.clear();
+}
+
+void History::setMemoryBudget(size_t budget)
+{
+    memoryBudget = budget;
+    evict();
+}
+
+void History::push(uint64_t generation, const uint32_t* words, size_t wordCount)
+{
+    if (!grid.empty() && wordCount == grid.size() && generation == cursor) return;
+    if (grid.empty() || wordCount != grid.size() || generation != cursor + 1) {
+        clear();
+        grid.assign(words, words + wordCount);
+        oldest = generation;
+        cursor = generation;
+        return;
+    }
+
+    // Continuing from a rewind, the generations that were ahead of the cursor are gone
+    while (getNewestGeneration() > cursor) {
+        memoryUsage -= changes.back().words.size() * sizeof(uint32_t);
+        changes.pop_back();
+    }
+
+    scratch.resize(wordCount);
+    for (size_t i = 0; i < wordCount; ++i) scratch[i] = grid[i] ^ words[i];
+    Change change;
+    std::vector<uint32_t> compressed;
+    ZeroRuns::compress(scratch.data(), wordCount, compressed);
+    if (compressed.size() < wordCount) {
+        change.words.assign(compressed.begin(), compressed.end());
+        change.compressed = true;
+    } else {
+        change.words.assign(scratch.begin(), scratch.end());
+    }
+    memoryUsage += change.words.size() * sizeof(uint32_t);
+    changes.push_back(std::move(change));
+    grid.assign(words, words + wordCount);
+    cursor = generation;
+    evict();
+}
+
+const std::vector<uint32_t>& History::seek(uint64_t generation)
+{
+    if (grid.empty() || generation < oldest || generation > getNewestGeneration()) {
+        throw HistoryError("Generation " + std::to_string(generation) + " is not in the history");
+    }
+    while (cursor > generation) apply(changes[--cursor - oldest]);
+    while (cursor < generation) apply(changes[cursor++ - oldest]);
+    return grid;
+}
+
+void History::apply(const Change& change)
+{
+    if (change.compressed) {
+        ZeroRuns::applyXor(change.words.data(), change.words.size(), grid.data(), grid.size());
+        return;
+    }
+    for (size_t i = 0; i < grid.size(); ++i) grid[i] ^= change.words[i];
+}
+
+void History::evict()
+{
+    // The cursor's own grid is always kept, so eviction stops at the cursor
+    while (memoryUsage > memoryBudget && !changes.empty() && oldest < cursor) {
+        memoryUsage -= changes.front().words.size() * sizeof(uint32_t);
+        changes.pop_front();
+        ++oldest;
+    }
+}
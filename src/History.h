@@ -0,0 +1,60 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Bounded rewind history of a bitpacked grid (32 cells per word, row y = 0 first).
+// Holds one full grid, the one at the cursor, plus the change set between every pair of consecutive
+// generations: their XOR, squeezed with ZeroRuns. XOR runs both ways, so the cursor moves backward
+// and forward one change set at a time, and a step back costs only as much as what changed.
+// Change sets are kept within memoryBudget bytes, dropping the oldest first.
+class History
+{
+public:
+    class HistoryError : public std::runtime_error {
+        public:
+            HistoryError(const std::string& msg)
+                : std::runtime_error("History failed: " + msg) {}
+    };
+
+    explicit History(size_t memoryBudget = 32ull << 20);
+
+    // Records the grid of generation. The generation after the cursor is appended, dropping any
+    // newer history first (the run continues from a rewind), the cursor's own generation is ignored,
+    // and anything else (a gap, or the first grid) starts the history over
+    void push(uint64_t generation, const uint32_t* grid, size_t wordCount);
+    // Moves the cursor to a generation between getOldestGeneration() and getNewestGeneration() and
+    // returns its grid, valid until the next call
+    const std::vector<uint32_t>& seek(uint64_t generation);
+    void clear();
+
+    bool isEmpty() const { return grid.empty(); }
+    uint64_t getOldestGeneration() const { return oldest; }
+    uint64_t getNewestGeneration() const { return oldest + changes.size(); }
+    uint64_t getCursorGeneration() const { return cursor; }
+    // Bytes held by change sets, the full grid comes on top
+    size_t getMemoryUsage() const { return memoryUsage; }
+    size_t getMemoryBudget() const { return memoryBudget; }
+    void setMemoryBudget(size_t budget);
+
+private:
+    struct Change {
+        std::vector<uint32_t> words;
+        bool compressed = false;
+    };
+
+    size_t memoryBudget;
+    size_t memoryUsage = 0;
+    // changes[i] takes generation oldest + i to oldest + i + 1 and back
+    std::deque<Change> changes;
+    uint64_t oldest = 0;
+    uint64_t cursor = 0;
+    std::vector<uint32_t> grid; // Generation cursor
+    std::vector<uint32_t> scratch;
+
+    void apply(const Change& change);
+    void evict();
+};
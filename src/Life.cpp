@@ -1,23 +1,110 @@
 #include "Life.h"
 #include "webgpu.hpp"
 #include "Shader.h"
+#include "Platform.h"
+#include "Random.h"
+#include <algorithm>
+#include <array>
+#include <cstdio>
+#include <cstring>
 #include <random>
-#include <emscripten/html5.h>
 
 Life::Life()
-    : cellStateArray(GRID_SIZE * GRID_SIZE)
+    : Life(Config{})
+{
+}
+
+Life::Life(const Config& config)
+    : config(config)
+    , initializationStart(std::chrono::steady_clock::now())
     , lastFrameTime(std::chrono::steady_clock::now())
 {
+    // Headless frames are exported at full resolution
+    adaptiveResolution = config.adaptiveResolution && !config.headless;
+    if (config.checkpoint) {
+        const Checkpoint::Info& info = config.checkpoint->getInfo();
+        if (info.width != info.height) throw Life::InitializationError("Checkpoints of square grids only");
+        this->config.gridSize = info.width;
+        this->config.rule = info.rule;
+        this->config.boundary = info.boundary;
+        this->config.seed = info.seed;
+    }
+    if (this->config.gridSize == 0) throw Life::InitializationError("Grid size must be positive");
+    if (this->config.packing == Packing::Bits && this->config.gridSize % 32 != 0) {
+        throw Life::InitializationError("Bitpacked state needs a grid width that is a multiple of 32");
+    }
+    if (this->config.stepsPerUpdate == 0) throw Life::InitializationError("An update needs at least one step");
+    if (this->config.stateRingDepth < this->config.stepsPerUpdate + 1) {
+        throw Life::InitializationError("The state ring needs at least " + std::to_string(this->config.stepsPerUpdate + 1)
+            + " buffers for " + std::to_string(this->config.stepsPerUpdate) + " steps per update");
+    }
+
+    // Change sets get what the resident grids leave, and at least half of the budget
+    const uint64_t historyResident = getHistoryResidentSize();
+    if (historyResident <= this->config.historyBudget / 2) {
+        history = std::make_unique<History>(static_cast<size_t>(this->config.historyBudget - historyResident));
+    }
+
+    if (this->config.seed == 0) {
+        std::random_device rd;
+        this->config.seed = (static_cast<uint64_t>(rd()) << 32) | rd();
+    }
+
+    // Adapter and device arrive through callbacks, setup continues in createResources
+    createInstance();
     requestAdapter();
-    requestDevice();
-    createSurface();
+}
+
+void Life::createResources()
+{
+    if (!config.headless) createSurface();
     configureSurface();
+    if (config.headless) createHeadlessTarget();
     createBindGroupLayout();
+
+    // Start shader compilation first, buffer creation and the initial upload overlap with it
+    pendingPipelines = config.packing == Packing::U32 ? PIPELINE_COUNT : PIPELINE_COUNT - 1;
     createPipelines();
-    createVertexBuffer();
+    createBlitPipeline();
+    createSeedPipeline();
+    if (config.packing == Packing::U32) createPackPipeline();
+    createRleCodec();
+
     createStorageBuffers();
     createUniformBuffer();
-    createBindGroup();
+    createBindGroups();
+    createOffscreenTarget();
+    buffersCreated = true;
+    finishInitialization();
+}
+
+void Life::onPipelineCreated()
+{
+    // Pipeline callbacks may fire before createResources has finished, or from the event loop after it
+    --pendingPipelines;
+    try {
+        finishInitialization();
+    } catch (...) {
+        initializationFailure = std::current_exception();
+    }
+}
+
+void Life::finishInitialization()
+{
+    if (ready || pendingPipelines > 0 || !buffersCreated) return;
+
+    // Render bundles record the render pipeline, so they are the last step
+    createRenderBundles();
+    if (config.checkpoint) {
+        restoreCheckpoint(*config.checkpoint);
+    } else if (config.pattern) {
+        const uint64_t x = (config.gridSize - std::min<uint64_t>(config.pattern->getWidth(), config.gridSize)) / 2;
+        const uint64_t y = (config.gridSize - std::min<uint64_t>(config.pattern->getHeight(), config.gridSize)) / 2;
+        loadRuns(*config.pattern, static_cast<uint32_t>(x), static_cast<uint32_t>(y));
+    } else if (!config.seedOnCpu) {
+        seed(config.seed, config.density);
+    }
+    ready = true;
 }
 
 Life::~Life()
@@ -25,35 +112,76 @@ Life::~Life()
     cleanup();
 }
 
+void Life::createInstance()
+{
+    instance = wgpu::createInstance();
+    if (!instance) throw Life::InitializationError("Failed to create instance");
+}
+
 void Life::requestAdapter()
 {
     wgpu::RequestAdapterOptions adapterOptions {};
     adapterOptions.setDefault();
-    adapter = instance.requestAdapter(adapterOptions);
-    if (!adapter) throw Life::InitializationError("Failed to request adapter");
+    adapterOptions.forceFallbackAdapter = config.forceFallbackAdapter;
+    adapterRequest = instance.requestAdapter(adapterOptions, 
+        [this](wgpu::RequestAdapterStatus status, wgpu::Adapter result, const char* message) {
+            if (status != wgpu::RequestAdapterStatus::Success || !result) {
+                failInitialization("Failed to request adapter", message);
+                return;
+            }
+            adapter = result;
+            requestDevice();
+        });
 }
 
 void Life::requestDevice()
 {
+    // Storage limits are raised to whatever the adapter supports, so grids are bounded by the GPU
+    // rather than the 128MB default binding size
+    wgpu::SupportedLimits supportedLimits {};
+    supportedLimits.setDefault();
+    adapter.getLimits(&supportedLimits);
+    wgpu::RequiredLimits requiredLimits {};
+    requiredLimits.setDefault();
+    requiredLimits.limits.maxStorageBufferBindingSize = supportedLimits.limits.maxStorageBufferBindingSize;
+    requiredLimits.limits.maxBufferSize = supportedLimits.limits.maxBufferSize;
+    maxStateBufferSize = std::min(supportedLimits.limits.maxStorageBufferBindingSize, supportedLimits.limits.maxBufferSize);
+
     wgpu::DeviceDescriptor deviceDesc {};
     deviceDesc.setDefault();
-    device = adapter.requestDevice(deviceDesc);
-    if (!device) throw Life::InitializationError("Failed to request device");
-    queue = device.getQueue();
-    if (!queue) throw Life::InitializationError("Failed to get queue");
+    deviceDesc.requiredLimits = &requiredLimits;
+    deviceRequest = adapter.requestDevice(deviceDesc, 
+        [this](wgpu::RequestDeviceStatus status, wgpu::Device result, const char* message) {
+            if (status != wgpu::RequestDeviceStatus::Success || !result) {
+                failInitialization("Failed to request device", message);
+                return;
+            }
+            device = result;
+            queue = device.getQueue();
+            if (!queue) {
+                failInitialization("Failed to get queue", nullptr);
+                return;
+            }
+            pipelineCache = std::make_unique<PipelineCache>(device);
 
+            // Exceptions can't cross the WebGPU callback, renderFrame rethrows them instead
+            try {
+                createResources();
+            } catch (...) {
+                initializationFailure = std::current_exception();
+            }
+        });
 }
 
-void Life::createSurface()
+void Life::failInitialization(const std::string& what, const char* message)
 {
-    wgpu::SurfaceDescriptorFromCanvasHTMLSelector surfaceSelector {};
-    surfaceSelector.setDefault();
-    surfaceSelector.selector = "#canvas";
+    initializationFailure = std::make_exception_ptr(
+        Life::InitializationError(message ? what + ": " + message : what));
+}
 
-    wgpu::SurfaceDescriptor surfaceDesc {};
-    surfaceDesc.setDefault();
-    surfaceDesc.nextInChain = reinterpret_cast<WGPUChainedStruct*>(&surfaceSelector);
-    surface = instance.createSurface(surfaceDesc);
+void Life::createSurface()
+{
+    surface = Platform::createSurface(instance);
 
     if (!surface) throw Life::InitializationError("Failed to create surface");    
 }
@@ -62,10 +190,17 @@ void Life::configureSurface()
 {
     surfaceConfig.setDefault();
     surfaceConfig.device = device;
-    surfaceConfig.format = getSurface().getPreferredFormat(adapter);
     surfaceConfig.usage = wgpu::TextureUsage::RenderAttachment;
+    if (config.headless) {
+        // No surface to configure, surfaceConfig only describes the offscreen frame
+        surfaceConfig.format = wgpu::TextureFormat::RGBA8Unorm;
+        surfaceConfig.width = config.frameWidth;
+        surfaceConfig.height = config.frameHeight;
+        return;
+    }
+    surfaceConfig.format = getSurface().getPreferredFormat(adapter);
     int width, height;
-    emscripten_get_canvas_element_size("#canvas", &width, &height);
+    Platform::getSurfaceSize(width, height);
     surfaceConfig.width = width;
     surfaceConfig.height = height;
     surface.configure(surfaceConfig);
@@ -83,7 +218,7 @@ void Life::createBindGroupLayout()
                                              wgpu::ShaderStage::Fragment | 
                                              wgpu::ShaderStage::Compute;
     uniformBindGroupLayoutEntry.buffer.type = wgpu::BufferBindingType::Uniform;
-    uniformBindGroupLayoutEntry.buffer.minBindingSize = sizeof(GRID_DIMENSIONS);
+    uniformBindGroupLayoutEntry.buffer.minBindingSize = GRID_UNIFORM_SIZE;
     entries[0] = uniformBindGroupLayoutEntry;
 
     // Binding 1: Cell state INPUT buffer (read-only storage)
@@ -94,7 +229,7 @@ void Life::createBindGroupLayout()
                                                    wgpu::ShaderStage::Fragment | 
                                                    wgpu::ShaderStage::Compute;
     inputStorageBindGroupLayoutEntry.buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
-    inputStorageBindGroupLayoutEntry.buffer.minBindingSize = cellStateArray.size() * sizeof(uint32_t);
+    inputStorageBindGroupLayoutEntry.buffer.minBindingSize = stateBufferSize();
     entries[1] = inputStorageBindGroupLayoutEntry;
 
     // Binding 2: Cell state OUTPUT buffer (read-write storage)
@@ -103,7 +238,7 @@ void Life::createBindGroupLayout()
     outputStorageBindGroupLayoutEntry.binding = 2;
     outputStorageBindGroupLayoutEntry.visibility = wgpu::ShaderStage::Compute;
     outputStorageBindGroupLayoutEntry.buffer.type = wgpu::BufferBindingType::Storage;
-    outputStorageBindGroupLayoutEntry.buffer.minBindingSize = cellStateArray.size() * sizeof(uint32_t);
+    outputStorageBindGroupLayoutEntry.buffer.minBindingSize = stateBufferSize();
     entries[2] = outputStorageBindGroupLayoutEntry;
 
     wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc {};
@@ -112,36 +247,28 @@ void Life::createBindGroupLayout()
     bindGroupLayoutDesc.entryCount = 3;
     bindGroupLayoutDesc.entries = entries.data();
 
-    bindGroupLayout = getDevice().createBindGroupLayout(bindGroupLayoutDesc);
+    bindGroupLayout = pipelineCache->bindGroupLayout(bindGroupLayoutDesc);
     if (!bindGroupLayout) throw Life::InitializationError("Failed to create bind group layout");   
+
+    // Render layout only exposes the uniform and the read-only state (bindings 0 and 1), so drawing
+    // one ring buffer never holds a writable usage on the buffer the compute pass is filling
+    wgpu::BindGroupLayoutDescriptor renderBindGroupLayoutDesc {};
+    renderBindGroupLayoutDesc.setDefault();
+    renderBindGroupLayoutDesc.label = "Cell render bind group layout";
+    renderBindGroupLayoutDesc.entryCount = 2;
+    renderBindGroupLayoutDesc.entries = entries.data();
+
+    renderBindGroupLayout = pipelineCache->bindGroupLayout(renderBindGroupLayoutDesc);
+    if (!renderBindGroupLayout) throw Life::InitializationError("Failed to create render bind group layout");
 }
 
 void Life::createPipelines()
 {
-    wgpu::ShaderModule cellShaderModule = Shader::loadModuleFromFile(
-        getDevice(),
-        "/shaders/shader.wgsl"
-    );
-
-    wgpu::PipelineLayoutDescriptor layoutDesc {};
-    layoutDesc.setDefault();
-    layoutDesc.bindGroupLayoutCount = 1;
-    layoutDesc.bindGroupLayouts = reinterpret_cast<const WGPUBindGroupLayout*>(&getBindGroupLayout());
-    wgpu::PipelineLayout pipelineLayout = getDevice().createPipelineLayout(layoutDesc);
-
-    // Vertex setup
-    wgpu::VertexAttribute vertexAttribute {};
-    vertexAttribute.setDefault();
-    vertexAttribute.format = wgpu::VertexFormat::Float32x2;
-    vertexAttribute.offset = 0;
-    vertexAttribute.shaderLocation = 0;
-
-    wgpu::VertexBufferLayout vertexBufferLayout {};
-    vertexBufferLayout.setDefault();
-    vertexBufferLayout.stepMode = wgpu::VertexStepMode::Vertex;
-    vertexBufferLayout.arrayStride = 8;
-    vertexBufferLayout.attributeCount = 1;
-    vertexBufferLayout.attributes = &vertexAttribute;
+    // Drawing only depends on the packing, so rule and boundary changes never touch the render pipeline
+    PipelineCache::Key sourceKey = 0;
+    wgpu::ShaderModule cellShaderModule = pipelineCache->shaderModule("shader.wgsl", renderShaderDefines(), sourceKey);
+    if (!cellShaderModule) throw Life::InitializationError("Failed to load cell shader");
+    wgpu::PipelineLayout pipelineLayout = pipelineCache->pipelineLayout(getRenderBindGroupLayout());
 
     // Pipeline descriptor
     wgpu::RenderPipelineDescriptor pipelineDesc {};
@@ -150,9 +277,7 @@ void Life::createPipelines()
     pipelineDesc.layout = pipelineLayout;
 
     pipelineDesc.vertex.module = cellShaderModule;
-    pipelineDesc.vertex.entryPoint = "vertexMain";
-    pipelineDesc.vertex.bufferCount = 1;
-    pipelineDesc.vertex.buffers = &vertexBufferLayout;
+    pipelineDesc.vertex.entryPoint = "vertexMain"; // Fullscreen triangle, no vertex buffers
 
     wgpu::ColorTargetState colorTarget {};
     colorTarget.setDefault();
@@ -168,19 +293,30 @@ void Life::createPipelines()
 
     pipelineDesc.fragment = &fragmentState;
 
-    renderPipeline = getDevice().createRenderPipeline(pipelineDesc);
+    // Both pipelines compile in the background, see onPipelineCreated
+    const PipelineCache::Key renderKey = PipelineCache::KeyBuilder()
+        .add(pipelineDesc.label).add(sourceKey).add(colorTarget.format)
+        .add(reinterpret_cast<uintptr_t>(static_cast<WGPUPipelineLayout>(pipelineLayout)))
+        .get();
+    pipelineCache->renderPipeline(renderKey, pipelineDesc, 
+        [this](wgpu::RenderPipeline pipeline, const char* message) {
+            if (!pipeline) {
+                failInitialization("Failed to create render pipeline", message);
+                return;
+            }
+            renderPipeline = pipeline;
+            onPipelineCreated();
+        });
 
-    // Create compute pipeline
-    wgpu::PipelineLayoutDescriptor computeLayoutDesc {};
-    computeLayoutDesc.setDefault();
-    computeLayoutDesc.bindGroupLayoutCount = 1;
-    computeLayoutDesc.bindGroupLayouts = reinterpret_cast<const WGPUBindGroupLayout*>(&getBindGroupLayout());
-    wgpu::PipelineLayout computePipelineLayout = getDevice().createPipelineLayout(computeLayoutDesc);
+    requestSimulationPipeline();
+}
 
-    // Define the override constant
-    wgpu::ConstantEntry constantEntry {};
-    constantEntry.key = "WORKGROUP_SIZE";
-    constantEntry.value = static_cast<double>(WORKGROUP_SIZE);
+void Life::requestSimulationPipeline()
+{
+    PipelineCache::Key sourceKey = 0;
+    wgpu::ShaderModule cellShaderModule = pipelineCache->shaderModule("shader.wgsl", shaderDefines(), sourceKey);
+    if (!cellShaderModule) throw Life::RuntimeError("Failed to load simulation shader");
+    wgpu::PipelineLayout computePipelineLayout = pipelineCache->pipelineLayout(getBindGroupLayout());
 
     wgpu::ComputePipelineDescriptor computePipelineDesc {};
     computePipelineDesc.setDefault();
@@ -188,29 +324,40 @@ void Life::createPipelines()
     computePipelineDesc.layout = computePipelineLayout;
     computePipelineDesc.compute.module = cellShaderModule;
     computePipelineDesc.compute.entryPoint = "computeMain";
-    computePipelineDesc.compute.constantCount = 1;
-    computePipelineDesc.compute.constants = &constantEntry;
 
-    simulationPipeline = getDevice().createComputePipeline(computePipelineDesc);
-    if (!simulationPipeline) throw Life::InitializationError("Failed to create compute pipeline");
+    // Rule, boundary and tile size are baked into the source, so sourceKey already tells variants apart
+    const PipelineCache::Key key = PipelineCache::KeyBuilder()
+        .add(computePipelineDesc.label).add(sourceKey)
+        .add(reinterpret_cast<uintptr_t>(static_cast<WGPUPipelineLayout>(computePipelineLayout)))
+        .get();
+    simulationPipelineKey = key;
+    const uint32_t workgroupSize = config.workgroupSize;
 
-    // Clean up temporary resources
-    computePipelineLayout.release();
-    cellShaderModule.release();
+    pipelineCache->computePipeline(key, computePipelineDesc, 
+        [this, key, workgroupSize](wgpu::ComputePipeline pipeline, const char* message) {
+            const bool initializing = !simulationPipeline;
+            if (!pipeline) {
+                if (initializing) failInitialization("Failed to create compute pipeline", message);
+                else pipelineFailure = std::make_exception_ptr(Life::RuntimeError(
+                    std::string("Failed to create compute pipeline: ") + (message ? message : "")));
+                return;
+            }
+            // Superseded by a later setSimulation, the pipeline stays cached for when it's asked for again
+            if (key != simulationPipelineKey) return;
+            simulationPipeline = pipeline;
+            simulationWorkgroupSize = workgroupSize;
+            if (initializing) onPipelineCreated();
+        });
 }
 
-void Life::createVertexBuffer()
+void Life::setSimulation(const Rule& rule, Boundary boundary, uint32_t workgroupSize)
 {
-    wgpu::BufferDescriptor bufferDesc {};
-    bufferDesc.setDefault();
-    bufferDesc.usage = wgpu::BufferUsage::Vertex | wgpu::BufferUsage::CopyDst;
-    bufferDesc.size = sizeof(VERTICES);
-    
-    vertexBuffer = getDevice().createBuffer(bufferDesc);
-    if (!vertexBuffer) throw Life::InitializationError("Failed to create vertexBuffer buffer");
+    config.rule = rule;
+    config.boundary = boundary;
+    config.workgroupSize = workgroupSize;
 
-    constexpr uint64_t BUFFER_OFFSET = 0;
-    getQueue().writeBuffer(vertexBuffer, BUFFER_OFFSET, VERTICES, sizeof(VERTICES));
+    // Before the device exists createPipelines picks the new variant up on its own
+    if (pipelineCache && bindGroupLayout) requestSimulationPipeline();
 }
 
 void Life::createUniformBuffer()
@@ -218,123 +365,966 @@ void Life::createUniformBuffer()
     wgpu::BufferDescriptor bufferDesc {};
     bufferDesc.setDefault();
     bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
-    bufferDesc.size = sizeof(GRID_DIMENSIONS);
+    bufferDesc.size = GRID_UNIFORM_SIZE;
     
     uniformBuffer = getDevice().createBuffer(bufferDesc);
     if (!uniformBuffer) throw Life::InitializationError("Failed to create uniform buffer");
 
+    // The grid dimensions ex. [256, 256] for 256x256 size grid
+    const float gridDimensions[2] = { static_cast<float>(config.gridSize), static_cast<float>(config.gridSize) };
     constexpr uint64_t BUFFER_OFFSET = 0;
-    getQueue().writeBuffer(uniformBuffer, BUFFER_OFFSET, GRID_DIMENSIONS, sizeof(GRID_DIMENSIONS));
+    getQueue().writeBuffer(uniformBuffer, BUFFER_OFFSET, gridDimensions, GRID_UNIFORM_SIZE);
 }
 
 void Life::createStorageBuffers()
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<> dis(0, 1);
-    for (auto& cell : cellStateArray) {
-        cell = dis(gen);
+    if (stateBufferSize() > maxStateBufferSize) {
+        throw Life::InitializationError("A " + std::to_string(config.gridSize) + "x" + std::to_string(config.gridSize) 
+            + " grid needs " + std::to_string(stateBufferSize()) + " bytes per state buffer, the device allows " 
+            + std::to_string(maxStateBufferSize));
     }
-    
+
+    // Generation 0 is seeded by the seeding pass once it has compiled, or on the host straight into
+    // mapped memory, one write per cell. Every other slot is fully written by a step before it is
+    // read, so it is never initialized at all. CopySrc lets the run-length encoder snapshot a slot
+    const bool seedOnHost = config.seedOnCpu && !config.pattern && !config.checkpoint;
+    const bool mapInitialState = seedOnHost && stateBufferSize() <= MAX_MAPPED_UPLOAD_SIZE;
     wgpu::BufferDescriptor bufferDesc {};
+    bufferDesc.setDefault();
     bufferDesc.label = "Cell State Storage";
-    bufferDesc.size = cellStateArray.size() * sizeof(uint32_t);
-    bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst; 
-    
-    // Create read buffer
-    cellBuffers.read = device.createBuffer(bufferDesc);
-    if (!cellBuffers.read) throw Life::InitializationError("Failed to create read storage buffer");
+    bufferDesc.size = stateBufferSize();
+    bufferDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst | wgpu::BufferUsage::CopySrc;
     
-    // Create write buffer
-    cellBuffers.write = device.createBuffer(bufferDesc);
-    if (!cellBuffers.write) throw Life::InitializationError("Failed to create write storage buffer");
+    cellBuffers.buffers.resize(config.stateRingDepth);
+    for (size_t i = 0; i < cellBuffers.buffers.size(); ++i) {
+        bufferDesc.mappedAtCreation = i == 0 && mapInitialState;
+        cellBuffers.buffers[i] = device.createBuffer(bufferDesc);
+        if (!cellBuffers.buffers[i]) throw Life::InitializationError("Failed to create cell state storage buffer");
+    }
+
+    if (config.packing == Packing::U32) {
+        wgpu::BufferDescriptor packedDesc {};
+        packedDesc.setDefault();
+        packedDesc.label = "Packed cells";
+        packedDesc.size = packedStateSize();
+        packedDesc.usage = wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc;
+        packedCells = device.createBuffer(packedDesc);
+        if (!packedCells) throw Life::InitializationError("Failed to create packed cell buffer");
+    }
     
-    // Initialize both buffers with the same data
-    constexpr uint64_t BUFFER_OFFSET = 0;
-    queue.writeBuffer(cellBuffers.read, BUFFER_OFFSET, cellStateArray.data(), 
-                     cellStateArray.size() * sizeof(uint32_t));
-    queue.writeBuffer(cellBuffers.write, BUFFER_OFFSET, cellStateArray.data(), 
-                     cellStateArray.size() * sizeof(uint32_t));
-}
-
-void Life::createBindGroup()
-{
-    // Create bind group A (reads from cellBuffers.read, writes to cellBuffers.write)
-    std::array<wgpu::BindGroupEntry, 3> readEntries;
-
-    readEntries[0].setDefault();
-    readEntries[0].binding = 0;
-    readEntries[0].buffer = getUniformBuffer();
-    readEntries[0].offset = 0;
-    readEntries[0].size = sizeof(GRID_DIMENSIONS);
-
-    readEntries[1].setDefault();
-    readEntries[1].binding = 1;
-    readEntries[1].buffer = cellBuffers.read;  // INPUT buffer
-    readEntries[1].offset = 0;
-    readEntries[1].size = cellStateArray.size() * sizeof(uint32_t);
-
-    // Binding 2 - OUTPUT buffer
-    readEntries[2].setDefault();
-    readEntries[2].binding = 2;
-    readEntries[2].buffer = cellBuffers.write;  // OUTPUT buffer
-    readEntries[2].offset = 0;
-    readEntries[2].size = cellStateArray.size() * sizeof(uint32_t);
-
-    wgpu::BindGroupDescriptor readBindGroupDesc {};
-    readBindGroupDesc.setDefault();
-    readBindGroupDesc.label = "Cell renderer bind group A";
-    readBindGroupDesc.layout = bindGroupLayout;
-    readBindGroupDesc.entryCount = readEntries.size();
-    readBindGroupDesc.entries = readEntries.data();
-
-    cellBuffers.readBindGroup = device.createBindGroup(readBindGroupDesc);
-    if (!cellBuffers.readBindGroup) throw Life::InitializationError("Failed to create read bindGroup");
-
-    // Create bind group B (reads from cellBuffers.write, writes to cellBuffers.read)
-    std::array<wgpu::BindGroupEntry, 3> writeEntries;
-
-    writeEntries[0].setDefault();
-    writeEntries[0].binding = 0;
-    writeEntries[0].buffer = getUniformBuffer();
-    writeEntries[0].offset = 0;
-    writeEntries[0].size = sizeof(GRID_DIMENSIONS);
-
-    writeEntries[1].setDefault();
-    writeEntries[1].binding = 1;
-    writeEntries[1].buffer = cellBuffers.write;
-    writeEntries[1].offset = 0;
-    writeEntries[1].size = cellStateArray.size() * sizeof(uint32_t);
-
-    writeEntries[2].setDefault();
-    writeEntries[2].binding = 2;
-    writeEntries[2].buffer = cellBuffers.read;
-    writeEntries[2].offset = 0;
-    writeEntries[2].size = cellStateArray.size() * sizeof(uint32_t);
-
-    wgpu::BindGroupDescriptor writeBindGroupDesc {};
-    writeBindGroupDesc.setDefault();
-    writeBindGroupDesc.label = "Cell renderer bind group B";
-    writeBindGroupDesc.layout = bindGroupLayout;
-    writeBindGroupDesc.entryCount = writeEntries.size();
-    writeBindGroupDesc.entries = writeEntries.data();
-
-    cellBuffers.writeBindGroup = device.createBindGroup(writeBindGroupDesc);
-    if (!cellBuffers.writeBindGroup) throw Life::InitializationError("Failed to create write bindGroup");
+    if (!seedOnHost) return;
+    const uint64_t totalWords = stateBufferSize() / sizeof(uint32_t);
+    if (mapInitialState) {
+        wgpu::Buffer& buffer = cellBuffers.buffers[0];
+        auto* words = static_cast<uint32_t*>(buffer.getMappedRange(0, stateBufferSize()));
+        if (!words) throw Life::InitializationError("Failed to map cell state storage buffer");
+        generateInitialState(words, 0, static_cast<size_t>(totalWords));
+        buffer.unmap();
+        return;
+    }
+
+    // Too large to map, generate and upload a chunk at a time (writeBuffer copies it out right away)
+    std::vector<uint32_t> chunk(UPLOAD_CHUNK_WORDS);
+    for (uint64_t offset = 0; offset < totalWords; offset += UPLOAD_CHUNK_WORDS) {
+        const size_t words = static_cast<size_t>(std::min<uint64_t>(UPLOAD_CHUNK_WORDS, totalWords - offset));
+        generateInitialState(chunk.data(), offset, words);
+        queue.writeBuffer(cellBuffers.buffers[0], offset * sizeof(uint32_t), chunk.data(), words * sizeof(uint32_t));
+    }
+}
+
+void Life::generateInitialState(uint32_t* words, uint64_t firstWord, size_t count) const
+{
+    // The same counter-based cells as the seeding pass, so seedOnCpu only changes where they are made
+    const uint32_t threshold = Random::densityThreshold(config.density);
+    const uint32_t columns = stateColumns();
+    std::vector<uint32_t> groups;
+    for (size_t i = 0; i < count;) {
+        const uint32_t row = static_cast<uint32_t>((firstWord + i) / columns);
+        const uint32_t column = static_cast<uint32_t>((firstWord + i) % columns);
+        const uint32_t run = static_cast<uint32_t>(std::min<uint64_t>(count - i, columns - column));
+
+        // Bitpacked variants store 32 cells per word, bit i of word w is cell w * 32 + i
+        if (config.packing == Packing::Bits) {
+            Random::fillCells(config.seed, row, column, run, threshold, words + i);
+            i += run;
+            continue;
+        }
+        // One word per cell, generate the groups of 32 the run overlaps and spread their bits
+        const uint32_t firstGroup = column / 32;
+        groups.resize((column + run - 1) / 32 - firstGroup + 1);
+        Random::fillCells(config.seed, row, firstGroup, static_cast<uint32_t>(groups.size()), threshold, groups.data());
+        for (uint32_t x = column; x < column + run; ++x, ++i) {
+            words[i] = (groups[x / 32 - firstGroup] >> (x % 32)) & 1u;
+        }
+    }
+}
+
+uint32_t Life::stateColumns() const
+{
+    return config.packing == Packing::Bits ? config.gridSize / 32 : config.gridSize;
+}
+
+uint64_t Life::stateBufferSize() const
+{
+    return static_cast<uint64_t>(stateColumns()) * config.gridSize * sizeof(uint32_t);
+}
+
+uint64_t Life::packedStateSize() const
+{
+    return static_cast<uint64_t>((config.gridSize + 31) / 32) * config.gridSize * sizeof(uint32_t);
+}
+
+uint64_t Life::getHistoryResidentSize() const
+{
+    const uint64_t copies = 2 + cellCaptureLimit() + (config.packing == Packing::U32 ? 1 : 0);
+    return copies * packedStateSize();
+}
+
+Shader::Defines Life::renderShaderDefines() const
+{
+    return { { "PACKED_BITS", config.packing == Packing::Bits ? "1" : "0" } };
+}
+
+Shader::Defines Life::shaderDefines() const
+{
+    auto hex = [](uint32_t mask) {
+        char text[16];
+        std::snprintf(text, sizeof(text), "0x%Xu", mask);
+        return std::string(text);
+    };
+    return {
+        { "WORKGROUP_SIZE", std::to_string(config.workgroupSize) + "u" },
+        { "BIRTH_MASK", hex(config.rule.birth) },
+        { "SURVIVE_MASK", hex(config.rule.survival) },
+        { "BOUNDARY_TORUS", config.boundary == Boundary::Torus ? "1" : "0" },
+        { "PACKED_BITS", config.packing == Packing::Bits ? "1" : "0" },
+    };
+}
+
+void Life::createBindGroups()
+{
+    const uint32_t depth = cellBuffers.depth();
+    const uint64_t stateSize = stateBufferSize();
+    cellBuffers.computeBindGroups.resize(depth);
+    cellBuffers.renderBindGroups.resize(depth);
+    if (config.packing == Packing::U32) packBindGroups.resize(depth);
+
+    for (uint32_t i = 0; i < depth; ++i) {
+        std::array<wgpu::BindGroupEntry, 3> entries;
+
+        // Binding 0 - Grid uniform
+        entries[0].setDefault();
+        entries[0].binding = 0;
+        entries[0].buffer = getUniformBuffer();
+        entries[0].offset = 0;
+        entries[0].size = GRID_UNIFORM_SIZE;
+
+        // Binding 1 - INPUT buffer, generation g
+        entries[1].setDefault();
+        entries[1].binding = 1;
+        entries[1].buffer = cellBuffers.buffers[i];
+        entries[1].offset = 0;
+        entries[1].size = stateSize;
+
+        // Binding 2 - OUTPUT buffer, generation g + 1
+        entries[2].setDefault();
+        entries[2].binding = 2;
+        entries[2].buffer = cellBuffers.buffers[(i + 1) % depth];
+        entries[2].offset = 0;
+        entries[2].size = stateSize;
+
+        wgpu::BindGroupDescriptor computeBindGroupDesc {};
+        computeBindGroupDesc.setDefault();
+        computeBindGroupDesc.label = "Cell simulation bind group";
+        computeBindGroupDesc.layout = bindGroupLayout;
+        computeBindGroupDesc.entryCount = entries.size();
+        computeBindGroupDesc.entries = entries.data();
+
+        cellBuffers.computeBindGroups[i] = device.createBindGroup(computeBindGroupDesc);
+        if (!cellBuffers.computeBindGroups[i]) throw Life::InitializationError("Failed to create simulation bindGroup");
+
+        wgpu::BindGroupDescriptor renderBindGroupDesc {};
+        renderBindGroupDesc.setDefault();
+        renderBindGroupDesc.label = "Cell renderer bind group";
+        renderBindGroupDesc.layout = renderBindGroupLayout;
+        renderBindGroupDesc.entryCount = 2;
+        renderBindGroupDesc.entries = entries.data();
+
+        cellBuffers.renderBindGroups[i] = device.createBindGroup(renderBindGroupDesc);
+        if (!cellBuffers.renderBindGroups[i]) throw Life::InitializationError("Failed to create render bindGroup");
+
+        if (config.packing != Packing::U32) continue;
+
+        // Binding 2 - Packed copy of generation g
+        entries[2].buffer = packedCells;
+        entries[2].size = packedStateSize();
+
+        wgpu::BindGroupDescriptor packBindGroupDesc {};
+        packBindGroupDesc.setDefault();
+        packBindGroupDesc.label = "Cell packing bind group";
+        packBindGroupDesc.layout = packBindGroupLayout;
+        packBindGroupDesc.entryCount = entries.size();
+        packBindGroupDesc.entries = entries.data();
+
+        packBindGroups[i] = device.createBindGroup(packBindGroupDesc);
+        if (!packBindGroups[i]) throw Life::InitializationError("Failed to create packing bindGroup");
+    }
+}
+
+void Life::createRenderBundles()
+{
+    // The draw only differs by which ring slot is bound, so record it once per slot
+    const WGPUTextureFormat colorFormat = surfaceConfig.format;
+    wgpu::RenderBundleEncoderDescriptor bundleEncoderDesc {};
+    bundleEncoderDesc.setDefault();
+    bundleEncoderDesc.label = "Cell render bundle encoder";
+    bundleEncoderDesc.colorFormatCount = 1;
+    bundleEncoderDesc.colorFormats = &colorFormat;
+
+    // One fullscreen triangle shading every pixel from its cell, see vertexMain in shader.wgsl
+    constexpr uint32_t FULLSCREEN_TRIANGLE_VERTICES = 3;
+    cellBuffers.renderBundles.resize(cellBuffers.depth());
+    for (uint32_t i = 0; i < cellBuffers.depth(); ++i) {
+        wgpu::RenderBundleEncoder bundleEncoder = getDevice().createRenderBundleEncoder(bundleEncoderDesc);
+        bundleEncoder.setPipeline(getRenderPipeline());
+        bundleEncoder.setBindGroup(0, cellBuffers.renderBindGroups[i], 0, nullptr);
+        bundleEncoder.draw(FULLSCREEN_TRIANGLE_VERTICES, 1, 0, 0);
+
+        wgpu::RenderBundleDescriptor bundleDesc {};
+        bundleDesc.setDefault();
+        bundleDesc.label = "Cell render bundle";
+        cellBuffers.renderBundles[i] = bundleEncoder.finish(bundleDesc);
+        bundleEncoder.release();
+        if (!cellBuffers.renderBundles[i]) throw Life::InitializationError("Failed to create render bundle");
+    }
+}
+
+void Life::createBlitPipeline()
+{
+    PipelineCache::Key sourceKey = 0;
+    wgpu::ShaderModule blitShaderModule = pipelineCache->shaderModule("blit.wgsl", {}, sourceKey);
+    if (!blitShaderModule) throw Life::InitializationError("Failed to load blit shader");
+
+    // Binding 0: Offscreen frame texture
+    wgpu::BindGroupLayoutEntry frameBindGroupLayoutEntry {};
+    frameBindGroupLayoutEntry.setDefault();
+    frameBindGroupLayoutEntry.binding = 0;
+    frameBindGroupLayoutEntry.visibility = wgpu::ShaderStage::Fragment;
+    frameBindGroupLayoutEntry.texture.sampleType = wgpu::TextureSampleType::Float;
+    frameBindGroupLayoutEntry.texture.viewDimension = wgpu::TextureViewDimension::_2D;
+
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc {};
+    bindGroupLayoutDesc.setDefault();
+    bindGroupLayoutDesc.label = "Blit bind group layout";
+    bindGroupLayoutDesc.entryCount = 1;
+    bindGroupLayoutDesc.entries = &frameBindGroupLayoutEntry;
+
+    blitBindGroupLayout = pipelineCache->bindGroupLayout(bindGroupLayoutDesc);
+    if (!blitBindGroupLayout) throw Life::InitializationError("Failed to create blit bind group layout");
+
+    wgpu::PipelineLayout pipelineLayout = pipelineCache->pipelineLayout(blitBindGroupLayout);
+
+    wgpu::RenderPipelineDescriptor pipelineDesc {};
+    pipelineDesc.setDefault();
+    pipelineDesc.label = "Blit pipeline";
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.vertex.module = blitShaderModule;
+    pipelineDesc.vertex.entryPoint = "vertexMain";
+    pipelineDesc.vertex.bufferCount = 0;
+
+    wgpu::ColorTargetState colorTarget {};
+    colorTarget.setDefault();
+    colorTarget.format = surfaceConfig.format;
+    colorTarget.writeMask = wgpu::ColorWriteMask::All;
+
+    wgpu::FragmentState fragmentState {};
+    fragmentState.setDefault();
+    fragmentState.module = blitShaderModule;
+    fragmentState.entryPoint = "fragmentMain";
+    fragmentState.targetCount = 1;
+    fragmentState.targets = &colorTarget;
+
+    pipelineDesc.fragment = &fragmentState;
+
+    const PipelineCache::Key key = PipelineCache::KeyBuilder()
+        .add(pipelineDesc.label).add(sourceKey).add(colorTarget.format)
+        .add(reinterpret_cast<uintptr_t>(static_cast<WGPUPipelineLayout>(pipelineLayout)))
+        .get();
+    pipelineCache->renderPipeline(key, pipelineDesc, 
+        [this](wgpu::RenderPipeline pipeline, const char* message) {
+            if (!pipeline) {
+                failInitialization("Failed to create blit pipeline", message);
+                return;
+            }
+            blitPipeline = pipeline;
+            onPipelineCreated();
+        });
+}
+
+void Life::createSeedPipeline()
+{
+    PipelineCache::Key sourceKey = 0;
+    wgpu::ShaderModule seedShaderModule = pipelineCache->shaderModule("seed.wgsl", renderShaderDefines(), sourceKey);
+    if (!seedShaderModule) throw Life::InitializationError("Failed to load seed shader");
+
+    std::array<wgpu::BindGroupLayoutEntry, 2> entries;
+
+    // Binding 0: Seed parameters
+    entries[0].setDefault();
+    entries[0].binding = 0;
+    entries[0].visibility = wgpu::ShaderStage::Compute;
+    entries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+    entries[0].buffer.minBindingSize = sizeof(SeedParams);
+
+    // Binding 1: Cell state being seeded
+    entries[1].setDefault();
+    entries[1].binding = 1;
+    entries[1].visibility = wgpu::ShaderStage::Compute;
+    entries[1].buffer.type = wgpu::BufferBindingType::Storage;
+    entries[1].buffer.minBindingSize = stateBufferSize();
+
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc {};
+    bindGroupLayoutDesc.setDefault();
+    bindGroupLayoutDesc.label = "Seed bind group layout";
+    bindGroupLayoutDesc.entryCount = entries.size();
+    bindGroupLayoutDesc.entries = entries.data();
+
+    seedBindGroupLayout = pipelineCache->bindGroupLayout(bindGroupLayoutDesc);
+    if (!seedBindGroupLayout) throw Life::InitializationError("Failed to create seed bind group layout");
+
+    wgpu::BufferDescriptor bufferDesc {};
+    bufferDesc.setDefault();
+    bufferDesc.label = "Seed parameters";
+    bufferDesc.usage = wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst;
+    bufferDesc.size = sizeof(SeedParams);
+    seedParamsBuffer = getDevice().createBuffer(bufferDesc);
+    if (!seedParamsBuffer) throw Life::InitializationError("Failed to create seed parameter buffer");
+
+    wgpu::PipelineLayout pipelineLayout = pipelineCache->pipelineLayout(seedBindGroupLayout);
+
+    wgpu::ComputePipelineDescriptor pipelineDesc {};
+    pipelineDesc.setDefault();
+    pipelineDesc.label = "Seed pipeline";
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.compute.module = seedShaderModule;
+    pipelineDesc.compute.entryPoint = "computeMain";
+
+    const PipelineCache::Key key = PipelineCache::KeyBuilder()
+        .add(pipelineDesc.label).add(sourceKey)
+        .add(reinterpret_cast<uintptr_t>(static_cast<WGPUPipelineLayout>(pipelineLayout)))
+        .get();
+    pipelineCache->computePipeline(key, pipelineDesc, 
+        [this](wgpu::ComputePipeline pipeline, const char* message) {
+            if (!pipeline) {
+                failInitialization("Failed to create seed pipeline", message);
+                return;
+            }
+            seedPipeline = pipeline;
+            onPipelineCreated();
+        });
+}
+
+void Life::createPackPipeline()
+{
+    PipelineCache::Key sourceKey = 0;
+    wgpu::ShaderModule packShaderModule = pipelineCache->shaderModule("pack.wgsl", {}, sourceKey);
+    if (!packShaderModule) throw Life::InitializationError("Failed to load packing shader");
+
+    std::array<wgpu::BindGroupLayoutEntry, 3> entries;
+
+    // Binding 0: Grid uniform
+    entries[0].setDefault();
+    entries[0].binding = 0;
+    entries[0].visibility = wgpu::ShaderStage::Compute;
+    entries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+    entries[0].buffer.minBindingSize = GRID_UNIFORM_SIZE;
+
+    // Binding 1: Cell state being read back
+    entries[1].setDefault();
+    entries[1].binding = 1;
+    entries[1].visibility = wgpu::ShaderStage::Compute;
+    entries[1].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+    entries[1].buffer.minBindingSize = stateBufferSize();
+
+    // Binding 2: Packed cells
+    entries[2].setDefault();
+    entries[2].binding = 2;
+    entries[2].visibility = wgpu::ShaderStage::Compute;
+    entries[2].buffer.type = wgpu::BufferBindingType::Storage;
+    entries[2].buffer.minBindingSize = packedStateSize();
+
+    wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc {};
+    bindGroupLayoutDesc.setDefault();
+    bindGroupLayoutDesc.label = "Packing bind group layout";
+    bindGroupLayoutDesc.entryCount = entries.size();
+    bindGroupLayoutDesc.entries = entries.data();
+
+    packBindGroupLayout = pipelineCache->bindGroupLayout(bindGroupLayoutDesc);
+    if (!packBindGroupLayout) throw Life::InitializationError("Failed to create packing bind group layout");
+
+    wgpu::PipelineLayout pipelineLayout = pipelineCache->pipelineLayout(packBindGroupLayout);
+
+    wgpu::ComputePipelineDescriptor pipelineDesc {};
+    pipelineDesc.setDefault();
+    pipelineDesc.label = "Packing pipeline";
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.compute.module = packShaderModule;
+    pipelineDesc.compute.entryPoint = "computeMain";
+
+    const PipelineCache::Key key = PipelineCache::KeyBuilder()
+        .add(pipelineDesc.label).add(sourceKey)
+        .add(reinterpret_cast<uintptr_t>(static_cast<WGPUPipelineLayout>(pipelineLayout)))
+        .get();
+    pipelineCache->computePipeline(key, pipelineDesc,
+        [this](wgpu::ComputePipeline pipeline, const char* message) {
+            if (!pipeline) {
+                failInitialization("Failed to create packing pipeline", message);
+                return;
+            }
+            packPipeline = pipeline;
+            onPipelineCreated();
+        });
+}
+
+void Life::createRleCodec()
+{
+    rleCodec = std::make_unique<RleCodec>(getDevice(), getQueue(), *pipelineCache, renderShaderDefines(), maxStateBufferSize,
+        [this](const char* message) {
+            if (message) {
+                failInitialization("Failed to create run-length codec pipelines", message);
+                return;
+            }
+            onPipelineCreated();
+        });
+}
+
+void Life::seed(uint64_t seed, float density, const SeedRegion& region)
+{
+    if (!seedPipeline) throw Life::RuntimeError("Seeding before the seed pipeline is ready");
+    resetHistory();
+
+    // Clamp the region, in 64 bits so the UINT32_MAX defaults don't overflow
+    const uint64_t gridSize = config.gridSize;
+    const uint64_t minX = std::min<uint64_t>(region.x, gridSize);
+    const uint64_t minY = std::min<uint64_t>(region.y, gridSize);
+    const uint64_t maxX = std::min<uint64_t>(minX + region.width, gridSize);
+    const uint64_t maxY = std::min<uint64_t>(minY + region.height, gridSize);
+    if (minX >= maxX || minY >= maxY) return;
+
+    SeedParams params {};
+    const uint64_t key = Random::key(seed);
+    params.key[0] = static_cast<uint32_t>(key);
+    params.key[1] = static_cast<uint32_t>(key >> 32);
+    params.rectMin[0] = static_cast<uint32_t>(minX);
+    params.rectMin[1] = static_cast<uint32_t>(minY);
+    params.rectMax[0] = static_cast<uint32_t>(maxX);
+    params.rectMax[1] = static_cast<uint32_t>(maxY);
+    params.width = config.gridSize;
+    params.threshold = Random::densityThreshold(density);
+    getQueue().writeBuffer(seedParamsBuffer, 0, &params, sizeof(params));
+
+    // The displayed generation is the one the next step reads
+    std::array<wgpu::BindGroupEntry, 2> entries;
+    entries[0].setDefault();
+    entries[0].binding = 0;
+    entries[0].buffer = seedParamsBuffer;
+    entries[0].size = sizeof(SeedParams);
+    entries[1].setDefault();
+    entries[1].binding = 1;
+    entries[1].buffer = cellBuffers.buffers[step % cellBuffers.depth()];
+    entries[1].size = stateBufferSize();
+
+    wgpu::BindGroupDescriptor bindGroupDesc {};
+    bindGroupDesc.setDefault();
+    bindGroupDesc.label = "Seed bind group";
+    bindGroupDesc.layout = seedBindGroupLayout;
+    bindGroupDesc.entryCount = entries.size();
+    bindGroupDesc.entries = entries.data();
+    wgpu::BindGroup bindGroup = getDevice().createBindGroup(bindGroupDesc);
+    if (!bindGroup) throw Life::RuntimeError("Failed to create seed bindGroup");
+
+    // One invocation per group of 32 cells along x
+    constexpr uint32_t SEED_WORKGROUP_SIZE = 8;
+    const uint64_t groupCount = (maxX + 31) / 32;
+    wgpu::CommandEncoder encoder = getDevice().createCommandEncoder();
+    wgpu::ComputePassEncoder computePass = encoder.beginComputePass();
+    computePass.setPipeline(seedPipeline);
+    computePass.setBindGroup(0, bindGroup, 0, nullptr);
+    computePass.dispatchWorkgroups(
+        static_cast<uint32_t>((groupCount + SEED_WORKGROUP_SIZE - 1) / SEED_WORKGROUP_SIZE),
+        static_cast<uint32_t>((maxY - minY + SEED_WORKGROUP_SIZE - 1) / SEED_WORKGROUP_SIZE),
+        1);
+    computePass.end();
+    wgpu::CommandBuffer commandBuffer = encoder.finish();
+    getQueue().submit(commandBuffer);
+
+    commandBuffer.release();
+    computePass.release();
+    encoder.release();
+    bindGroup.release();
+}
+
+void Life::loadPattern(const Pattern& pattern, uint32_t x, uint32_t y)
+{
+    resetHistory();
+    wgpu::Buffer& buffer = cellBuffers.buffers[step % cellBuffers.depth()];
+    wgpu::CommandEncoder encoder = getDevice().createCommandEncoder();
+    encoder.clearBuffer(buffer, 0, stateBufferSize());
+    wgpu::CommandBuffer commandBuffer = encoder.finish();
+    getQueue().submit(commandBuffer);
+    commandBuffer.release();
+    encoder.release();
+
+    // Rows are laid out in the state format a chunk at a time, writes are ordered after the clear
+    const uint64_t gridSize = config.gridSize;
+    const uint64_t beginRow = std::min<uint64_t>(y, gridSize);
+    const uint64_t endRow = std::min<uint64_t>(static_cast<uint64_t>(y) + pattern.getHeight(), gridSize);
+    const uint32_t columns = stateColumns();
+    const uint64_t rowsPerChunk = std::max<uint64_t>(1, UPLOAD_CHUNK_WORDS / columns);
+    std::vector<uint32_t> packedRow((gridSize + 31) / 32);
+    std::vector<uint32_t> chunk;
+    for (uint64_t first = beginRow; first < endRow; first += rowsPerChunk) {
+        const uint64_t last = std::min(endRow, first + rowsPerChunk);
+        chunk.assign(static_cast<size_t>((last - first) * columns), 0u);
+        for (uint64_t gridY = first; gridY < last; ++gridY) {
+            const uint32_t patternY = static_cast<uint32_t>(pattern.getHeight() - 1 - (gridY - y));
+            uint32_t* target = chunk.data() + (gridY - first) * columns;
+            if (config.packing == Packing::Bits) {
+                pattern.blitRow(patternY, x, target, config.gridSize);
+                continue;
+            }
+            std::fill(packedRow.begin(), packedRow.end(), 0u);
+            pattern.blitRow(patternY, x, packedRow.data(), config.gridSize);
+            for (uint32_t cell = 0; cell < config.gridSize; ++cell) target[cell] = (packedRow[cell / 32] >> (cell % 32)) & 1u;
+        }
+        getQueue().writeBuffer(buffer, first * columns * sizeof(uint32_t), chunk.data(), chunk.size() * sizeof(uint32_t));
+    }
+}
+
+void Life::loadRuns(const Pattern::Runs& runs, uint32_t x, uint32_t y)
+{
+    if (!rleCodec || !rleCodec->isReady()) throw Life::RuntimeError("Decoding runs before the run-length codec is ready");
+    resetHistory();
+    try {
+        rleCodec->decode(cellBuffers.buffers[step % cellBuffers.depth()], config.gridSize, runs, x, y);
+    } catch (const RleCodec::CodecError& e) {
+        throw Life::RuntimeError(e.what());
+    }
+}
+
+void Life::encodeRuns(RleCodec::Encoded&& done)
+{
+    if (!rleCodec || !rleCodec->isReady()) throw Life::RuntimeError("Encoding runs before the run-length codec is ready");
+    const Rule rule = config.rule;
+    try {
+        rleCodec->encode(cellBuffers.buffers[step % cellBuffers.depth()], config.gridSize,
+            [rule, done = std::move(done)](Pattern::Runs&& runs, const char* message) {
+                runs.rule = rule;
+                done(std::move(runs), message);
+            });
+    } catch (const RleCodec::CodecError& e) {
+        throw Life::RuntimeError(e.what());
+    }
+}
+
+Pattern::Runs Life::readRuns()
+{
+    Pattern::Runs result;
+    std::string failure;
+    bool finished = false;
+    encodeRuns([&](Pattern::Runs&& runs, const char* message) {
+        if (message) failure = message;
+        result = std::move(runs);
+        finished = true;
+    });
+    while (!finished) waitForEvents();
+    if (!failure.empty()) throw Life::RuntimeError(failure);
+    return result;
+}
+
+void Life::restoreCheckpoint(const Checkpoint& checkpoint)
+{
+    const Checkpoint::Info& info = checkpoint.getInfo();
+    if (info.width != config.gridSize || info.height != config.gridSize) {
+        throw Life::RuntimeError("Checkpoint is " + std::to_string(info.width) + "x" + std::to_string(info.height)
+            + ", the grid " + std::to_string(config.gridSize) + "x" + std::to_string(config.gridSize));
+    }
+
+    // Every row is written, so the slot needs no clear
+    try {
+        checkpoint.readRows(0, info.height, [this](uint32_t firstRow, uint32_t rowCount, const uint32_t* words) {
+            uploadCells(words, firstRow, rowCount);
+        });
+    } catch (const Checkpoint::CheckpointError& e) {
+        throw Life::RuntimeError(e.what());
+    }
+    resetHistory();
+    generationOffset = info.generation - step;
+}
+
+void Life::uploadCells(const uint32_t* words, uint32_t firstRow, uint32_t rowCount)
+{
+    // Bitpacked rows already are the state layout, so they go straight from the caller's memory
+    wgpu::Buffer& buffer = cellBuffers.buffers[step % cellBuffers.depth()];
+    const uint32_t columns = stateColumns();
+    const uint32_t wordsPerRow = (config.gridSize + 31) / 32;
+    if (config.packing == Packing::Bits) {
+        getQueue().writeBuffer(buffer, static_cast<uint64_t>(firstRow) * columns * sizeof(uint32_t),
+                               words, static_cast<size_t>(rowCount) * wordsPerRow * sizeof(uint32_t));
+        return;
+    }
+    const uint32_t rowsPerChunk = static_cast<uint32_t>(std::max<uint64_t>(1, UPLOAD_CHUNK_WORDS / columns));
+    std::vector<uint32_t> chunk;
+    for (uint32_t first = 0; first < rowCount; first += rowsPerChunk) {
+        const uint32_t last = std::min(rowCount, first + rowsPerChunk);
+        chunk.resize(static_cast<size_t>(last - first) * columns);
+        for (uint32_t y = first; y < last; ++y) {
+            const uint32_t* packed = words + static_cast<size_t>(y) * wordsPerRow;
+            uint32_t* target = chunk.data() + static_cast<size_t>(y - first) * columns;
+            for (uint32_t cell = 0; cell < config.gridSize; ++cell) target[cell] = (packed[cell / 32] >> (cell % 32)) & 1u;
+        }
+        getQueue().writeBuffer(buffer, static_cast<uint64_t>(firstRow + first) * columns * sizeof(uint32_t),
+                               chunk.data(), chunk.size() * sizeof(uint32_t));
+    }
+}
+
+void Life::resetHistory()
+{
+    lastCapturedGeneration = UINT64_MAX;
+    if (!history) return;
+    history->clear();
+    ++historyEpoch;
+}
+
+void Life::copyPackedCells(const wgpu::CommandEncoder& encoder, uint64_t stateStep, const wgpu::Buffer& target)
+{
+    const uint32_t slot = static_cast<uint32_t>(stateStep % cellBuffers.depth());
+    if (config.packing == Packing::Bits) {
+        encoder.copyBufferToBuffer(cellBuffers.buffers[slot], 0, target, 0, packedStateSize());
+        return;
+    }
+
+    // One invocation per packed word, packedCells is only reused by copies recorded after this one
+    constexpr uint32_t PACK_WORKGROUP_SIZE = 8;
+    const uint32_t wordsPerRow = (config.gridSize + 31) / 32;
+    wgpu::ComputePassEncoder computePass = encoder.beginComputePass();
+    computePass.setPipeline(packPipeline);
+    computePass.setBindGroup(0, packBindGroups[slot], 0, nullptr);
+    computePass.dispatchWorkgroups((wordsPerRow + PACK_WORKGROUP_SIZE - 1) / PACK_WORKGROUP_SIZE,
+                                   (config.gridSize + PACK_WORKGROUP_SIZE - 1) / PACK_WORKGROUP_SIZE, 1);
+    computePass.end();
+    computePass.release();
+    encoder.copyBufferToBuffer(packedCells, 0, target, 0, packedStateSize());
+}
+
+size_t Life::cellCaptureLimit() const
+{
+    // A frame captures at most the generations the ring holds, so a recording waiting for a free
+    // buffer always has one submitted by an earlier frame to wait on
+    return std::max<size_t>(MAX_CELL_CAPTURES_IN_FLIGHT, config.stateRingDepth + 1);
+}
+
+void Life::captureCells(const wgpu::CommandEncoder& encoder, uint64_t displayedStep)
+{
+    // Every generation since the last capture that is still in the ring, up to the displayed one or,
+    // after an update of several steps, up to the one before the newest (which the next frame shows)
+    const uint64_t lastStep = step > displayedStep ? step - 1 : displayedStep;
+    const uint64_t oldestStep = step >= cellBuffers.depth() - 1 ? step - (cellBuffers.depth() - 1) : 0;
+    uint64_t firstStep = displayedStep;
+    if (lastCapturedGeneration != UINT64_MAX) {
+        firstStep = std::max(lastCapturedGeneration - generationOffset + 1, oldestStep);
+    }
+    for (uint64_t capturedStep = firstStep; capturedStep <= lastStep; ++capturedStep) {
+        if (CellCapture* capture = captureCell(encoder, capturedStep)) frameCaptures.push_back(capture);
+    }
+}
+
+Life::CellCapture* Life::captureCell(const wgpu::CommandEncoder& encoder, uint64_t capturedStep)
+{
+    auto freeCapture = [this]() -> CellCapture* {
+        for (auto& capture : cellCaptures) if (!capture->inFlight) return capture.get();
+        return nullptr;
+    };
+    CellCapture* capture = freeCapture();
+    if (!capture && cellCaptures.size() < cellCaptureLimit()) {
+        wgpu::BufferDescriptor bufferDesc {};
+        bufferDesc.setDefault();
+        bufferDesc.label = "Cell capture";
+        bufferDesc.size = packedStateSize();
+        bufferDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+        cellCaptures.push_back(std::make_unique<CellCapture>());
+        capture = cellCaptures.back().get();
+        capture->buffer = getDevice().createBuffer(bufferDesc);
+        if (!capture->buffer) throw Life::RuntimeError("Failed to create cell capture buffer");
+    }
+    // A recording waits for the oldest capture, history alone misses this generation and starts over
+    while (!capture && cellRecorder) {
+        waitForEvents();
+        capture = freeCapture();
+    }
+    if (!capture) return nullptr;
+
+    capture->generation = generationOffset + capturedStep;
+    capture->epoch = historyEpoch;
+    capture->inFlight = true;
+    lastCapturedGeneration = capture->generation;
+    copyPackedCells(encoder, capturedStep, capture->buffer);
+    return capture;
+}
+
+void Life::requestCellMap(CellCapture& capture)
+{
+    capture.mapCallback = capture.buffer.mapAsync(wgpu::MapMode::Read, 0, packedStateSize(),
+        [this, &capture](wgpu::BufferMapAsyncStatus status) {
+            capture.inFlight = false;
+            if (status != wgpu::BufferMapAsyncStatus::Success) {
+                if (cellRecorder && !exportFailure) {
+                    exportFailure = std::make_exception_ptr(Life::RuntimeError("Failed to map cell capture buffer"));
+                }
+                return;
+            }
+            const auto* words = static_cast<const uint32_t*>(capture.buffer.getConstMappedRange(0, packedStateSize()));
+            const size_t wordCount = static_cast<size_t>(packedStateSize() / sizeof(uint32_t));
+            if (history && capture.epoch == historyEpoch) history->push(capture.generation, words, wordCount);
+            try {
+                if (cellRecorder) cellRecorder->submit(capture.generation, std::vector<uint32_t>(words, words + wordCount));
+            } catch (...) {
+                if (!exportFailure) exportFailure = std::current_exception();
+            }
+            capture.buffer.unmap();
+        });
+}
+
+void Life::rewind(uint64_t generation)
+{
+    if (!history || history->isEmpty()) throw Life::RuntimeError("No history to rewind");
+    try {
+        const std::vector<uint32_t>& grid = history->seek(generation);
+        uploadCells(grid.data(), 0, config.gridSize);
+    } catch (const History::HistoryError& e) {
+        throw Life::RuntimeError(e.what());
+    }
+    // Captures in flight hold generations past the new one
+    ++historyEpoch;
+    lastCapturedGeneration = UINT64_MAX;
+    generationOffset = generation - step;
+    redrawPending = true;
+}
+
+void Life::stepBackward()
+{
+    setPaused(true);
+    if (history && !history->isEmpty() && getGeneration() > history->getOldestGeneration()) {
+        rewind(std::min(getGeneration() - 1, history->getNewestGeneration()));
+    }
+}
+
+void Life::stepForward()
+{
+    setPaused(true);
+    if (history && !history->isEmpty() && getGeneration() < history->getNewestGeneration()) {
+        rewind(getGeneration() + 1);
+    } else {
+        stepPending = true;
+    }
+}
+
+void Life::setCells(const uint32_t* words, uint64_t generation)
+{
+    if (!ready) throw Life::RuntimeError("Setting cells before initialization has finished");
+    uploadCells(words, 0, config.gridSize);
+    resetHistory();
+    generationOffset = generation - step;
+}
+
+void Life::waitUntilReady()
+{
+    while (!ready) {
+        if (initializationFailure) std::rethrow_exception(initializationFailure);
+        if (pipelineFailure) std::rethrow_exception(pipelineFailure);
+        waitForEvents();
+    }
+}
+
+void Life::simulate(uint64_t generations)
+{
+    if (!ready) throw Life::RuntimeError("Simulating before initialization has finished");
+    if (!Platform::canBlock()) throw Life::RuntimeError("Cannot wait for GPU callbacks on this platform");
+    resetHistory();
+
+    const uint32_t workgroupCountX = (stateColumns() + simulationWorkgroupSize - 1) / simulationWorkgroupSize;
+    const uint32_t workgroupCountY = (config.gridSize + simulationWorkgroupSize - 1) / simulationWorkgroupSize;
+
+    // At most one batch waits in the queue, so a callback slot is only reused once its batch is done
+    std::array<std::unique_ptr<wgpu::QueueWorkDoneCallback>, 2> doneCallbacks;
+    uint64_t submitted = 0;
+    uint64_t completed = 0;
+    bool failed = false;
+    while (generations > 0) {
+        while (completed + 1 < submitted) waitForEvents();
+
+        const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(generations, SIMULATE_BATCH_STEPS));
+        wgpu::CommandEncoder encoder = getDevice().createCommandEncoder();
+        wgpu::ComputePassEncoder computePass = encoder.beginComputePass();
+        computePass.setPipeline(getSimulationPipeline());
+        for (uint32_t i = 0; i < count; ++i) {
+            computePass.setBindGroup(0, cellBuffers.computeBindGroupFor(step), 0, nullptr);
+            computePass.dispatchWorkgroups(workgroupCountX, workgroupCountY, 1);
+            step++;
+        }
+        computePass.end();
+        wgpu::CommandBuffer commandBuffer = encoder.finish();
+        getQueue().submit(commandBuffer);
+        commandBuffer.release();
+        computePass.release();
+        encoder.release();
+
+        doneCallbacks[submitted % doneCallbacks.size()] = getQueue().onSubmittedWorkDone(
+            [&completed, &failed](wgpu::QueueWorkDoneStatus status) {
+                if (status != wgpu::QueueWorkDoneStatus::Success) failed = true;
+                ++completed;
+            });
+        ++submitted;
+        generations -= count;
+    }
+    while (completed < submitted) waitForEvents();
+    if (failed) throw Life::RuntimeError("Simulation work failed on the queue");
+}
+
+void Life::readCells(std::vector<uint32_t>& words)
+{
+    if (!ready) throw Life::RuntimeError("Reading cells before initialization has finished");
+
+    // The ring slot keeps being stepped, so the displayed generation is copied out first
+    wgpu::BufferDescriptor bufferDesc {};
+    bufferDesc.setDefault();
+    bufferDesc.label = "Cell readback";
+    bufferDesc.size = packedStateSize();
+    bufferDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+    wgpu::Buffer readback = getDevice().createBuffer(bufferDesc);
+    if (!readback) throw Life::RuntimeError("Failed to create cell readback buffer");
+
+    wgpu::CommandEncoder encoder = getDevice().createCommandEncoder();
+    copyPackedCells(encoder, step, readback);
+    wgpu::CommandBuffer commandBuffer = encoder.finish();
+    getQueue().submit(commandBuffer);
+    commandBuffer.release();
+    encoder.release();
+
+    bool mapped = false;
+    bool finished = false;
+    std::unique_ptr<wgpu::BufferMapCallback> mapCallback = readback.mapAsync(wgpu::MapMode::Read, 0, packedStateSize(),
+        [&](wgpu::BufferMapAsyncStatus status) {
+            mapped = status == wgpu::BufferMapAsyncStatus::Success;
+            finished = true;
+        });
+    std::exception_ptr failure;
+    try {
+        while (!finished) waitForEvents();
+        if (!mapped) throw Life::RuntimeError("Failed to map cell readback buffer");
+
+        const auto* cells = static_cast<const uint32_t*>(readback.getConstMappedRange(0, packedStateSize()));
+        words.assign(cells, cells + packedStateSize() / sizeof(uint32_t));
+    } catch (...) {
+        failure = std::current_exception();
+    }
+    if (mapped) readback.unmap();
+    readback.destroy();
+    readback.release();
+    if (failure) std::rethrow_exception(failure);
+}
+
+void Life::saveCheckpoint(const std::string& path, bool compress)
+{
+    std::vector<uint32_t> words;
+    readCells(words);
+    Checkpoint::Info info;
+    info.width = config.gridSize;
+    info.height = config.gridSize;
+    info.rule = config.rule;
+    info.boundary = config.boundary;
+    info.generation = getGeneration();
+    info.seed = config.seed;
+    const size_t wordsPerRow = (config.gridSize + 31) / 32;
+    try {
+        Checkpoint::save(path, info, [&](uint32_t y, uint32_t* row) {
+            std::copy_n(words.data() + y * wordsPerRow, wordsPerRow, row);
+        }, compress);
+    } catch (const Checkpoint::CheckpointError& e) {
+        throw Life::RuntimeError(e.what());
+    }
+}
+
+void Life::createOffscreenTarget()
+{
+    if (blitBindGroup) blitBindGroup.release();
+    if (offscreenView) offscreenView.release();
+    if (offscreenTexture) {
+        offscreenTexture.destroy();
+        offscreenTexture.release();
+    }
+    blitBindGroup = nullptr;
+    offscreenView = nullptr;
+    offscreenTexture = nullptr;
+    if (!adaptiveResolution) return;
+
+    // Never shade more than CELL_PIXELS per cell, whatever the canvas size
+    const uint64_t cellPixels = static_cast<uint64_t>(config.gridSize) * CELL_PIXELS;
+    const uint32_t fullWidth = static_cast<uint32_t>(std::min<uint64_t>(cellPixels, surfaceConfig.width));
+    const uint32_t fullHeight = static_cast<uint32_t>(std::min<uint64_t>(cellPixels, surfaceConfig.height));
+
+    wgpu::TextureDescriptor textureDesc {};
+    textureDesc.setDefault();
+    textureDesc.label = "Offscreen cell frame";
+    // Scaled down, a cell keeps at least one pixel unless the surface itself is smaller than the grid
+    const uint32_t minWidth = std::min<uint32_t>(config.gridSize, fullWidth);
+    const uint32_t minHeight = std::min<uint32_t>(config.gridSize, fullHeight);
+    textureDesc.size.width = std::max({ 1u, minWidth, static_cast<uint32_t>(fullWidth * renderScale) });
+    textureDesc.size.height = std::max({ 1u, minHeight, static_cast<uint32_t>(fullHeight * renderScale) });
+    textureDesc.format = surfaceConfig.format;
+    textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::TextureBinding;
+
+    offscreenTexture = getDevice().createTexture(textureDesc);
+    if (!offscreenTexture) throw Life::RuntimeError("Failed to create offscreen texture");
+    offscreenView = offscreenTexture.createView();
+
+    wgpu::BindGroupEntry frameEntry {};
+    frameEntry.setDefault();
+    frameEntry.binding = 0;
+    frameEntry.textureView = offscreenView;
+
+    wgpu::BindGroupDescriptor bindGroupDesc {};
+    bindGroupDesc.setDefault();
+    bindGroupDesc.label = "Blit bind group";
+    bindGroupDesc.layout = blitBindGroupLayout;
+    bindGroupDesc.entryCount = 1;
+    bindGroupDesc.entries = &frameEntry;
+
+    blitBindGroup = getDevice().createBindGroup(bindGroupDesc);
+    if (!blitBindGroup) throw Life::RuntimeError("Failed to create blit bindGroup");
 }
 
 void Life::cleanup()
 {
+    for (auto& slot : readbackSlots) if (slot->buffer) slot->buffer.release();
+    for (auto& capture : cellCaptures) if (capture->buffer) capture->buffer.release();
+    for (auto& group : packBindGroups) if (group) group.release();
+    if (packedCells) packedCells.release();
+    if (headlessView) headlessView.release();
+    if (headlessTexture) headlessTexture.release();
+    if (blitBindGroup) blitBindGroup.release();
+    if (offscreenView) offscreenView.release();
+    if (offscreenTexture) offscreenTexture.release();
     if (bindGroup) bindGroup.release();
-    if (cellBuffers.writeBindGroup) cellBuffers.writeBindGroup.release();
-    if (cellBuffers.readBindGroup) cellBuffers.readBindGroup.release();
-    if (cellBuffers.write) cellBuffers.write.release();
-    if (cellBuffers.read) cellBuffers.read.release();
-    if (bindGroupLayout) bindGroupLayout.release();
+    for (auto& bundle : cellBuffers.renderBundles) if (bundle) bundle.release();
+    for (auto& group : cellBuffers.renderBindGroups) if (group) group.release();
+    for (auto& group : cellBuffers.computeBindGroups) if (group) group.release();
+    for (auto& buffer : cellBuffers.buffers) if (buffer) buffer.release();
+    if (seedParamsBuffer) seedParamsBuffer.release();
     if (uniformBuffer) uniformBuffer.release();
-    if (vertexBuffer) vertexBuffer.release();
-    if (renderPipeline) renderPipeline.release();
-    if (simulationPipeline) simulationPipeline.release();
+    // Pipelines and layouts belong to the cache, which must outlive the codec's requests
+    rleCodec.reset();
+    pipelineCache.reset();
     if (surface) surface.release();
     if (queue) queue.release();
     if (device) device.release();
@@ -344,39 +1334,85 @@ void Life::cleanup()
 
 void Life::renderFrame()
 {
-    if (!shouldUpdateCells()) {
+    if (initializationFailure) std::rethrow_exception(initializationFailure);
+    if (exportFailure) std::rethrow_exception(exportFailure);
+    if (pipelineFailure) std::rethrow_exception(pipelineFailure);
+
+    // Deliver pending callbacks (adapter, device, readbacks), the browser does this on its own
+    Platform::processEvents(instance);
+    if (!ready) {
         return;
     }
-    
+
+    // Headless runs are paced by the caller, every call is one update. Paused, a frame is only drawn
+    // to show a rewind or a single step
+    const bool advance = !paused || stepPending;
+    if (paused && !advance && !redrawPending) {
+        return;
+    }
+    if (!config.headless && !paused && !shouldUpdateCells()) {
+        return;
+    }
+    stepPending = false;
+    redrawPending = false;
+
     // Create command encoder
     wgpu::CommandEncoder encoder = getDevice().createCommandEncoder();
 
-    // Compute Shader Pass
-    wgpu::ComputePassEncoder computePass = encoder.beginComputePass();
-    computePass.setPipeline(getSimulationPipeline());
-    
-    // Alternate between bind groups each step
-    wgpu::BindGroup currentBindGroup = (step % 2 == 0) 
-        ? cellBuffers.readBindGroup 
-        : cellBuffers.writeBindGroup;
-    computePass.setBindGroup(0, currentBindGroup, 0, nullptr);
-    
-    // Calculate workgroup count
-    const uint32_t workgroupCount = (GRID_SIZE + WORKGROUP_SIZE - 1) / WORKGROUP_SIZE;
-    computePass.dispatchWorkgroups(workgroupCount, workgroupCount, 1);
-    
-    computePass.end();
-    
-    step++;
+    // The frame draws the generation that was current before this update,
+    // so its ring slot is never touched by the compute work recorded below
+    uint64_t displayedStep = step;
+
+    if (advance) {
+        // Compute Shader Pass
+        wgpu::ComputePassEncoder computePass = encoder.beginComputePass();
+        computePass.setPipeline(getSimulationPipeline());
+
+        // Calculate workgroup count, bitpacked variants have one invocation per word
+        const uint32_t workgroupCountX = (stateColumns() + simulationWorkgroupSize - 1) / simulationWorkgroupSize;
+        const uint32_t workgroupCountY = (config.gridSize + simulationWorkgroupSize - 1) / simulationWorkgroupSize;
+
+        // Each step reads ring slot step and writes slot step + 1. Paused, the update is a single step
+        const uint32_t steps = paused ? 1 : config.stepsPerUpdate;
+        for (uint32_t i = 0; i < steps; ++i) {
+            computePass.setBindGroup(0, cellBuffers.computeBindGroupFor(step), 0, nullptr);
+            computePass.dispatchWorkgroups(workgroupCountX, workgroupCountY, 1);
+            step++;
+        }
+
+        computePass.end();
+        computePass.release();
+        // A single step shows its result right away rather than overlapping with the next update
+        if (paused) displayedStep = step;
+    }
+    frameCaptures.clear();
+    if (history || cellRecorder) captureCells(encoder, displayedStep);
+
+    // A timed frame submits the simulation and history copy on their own, so the timer only sees the
+    // render and blit work that the render scale can actually shrink
+    const bool timeFrame = adaptiveResolution && !frameTimingPending;
+    if (timeFrame) {
+        wgpu::CommandBuffer simulationCommands = encoder.finish();
+        getQueue().submit(simulationCommands);
+        simulationCommands.release();
+        encoder.release();
+        encoder = getDevice().createCommandEncoder();
+        startFrameTiming();
+    }
 
     // ========== RENDER PASS - Draw the cells ==========
-    wgpu::SurfaceTexture surfaceTexture {};
-    getSurface().getCurrentTexture(&surfaceTexture);
-    wgpu::Texture texture = surfaceTexture.texture;
-    wgpu::TextureView view = texture.createView();
+    updateRenderScale();
+
+    wgpu::TextureView view = headlessView;
+    if (!config.headless) {
+        wgpu::SurfaceTexture surfaceTexture {};
+        getSurface().getCurrentTexture(&surfaceTexture);
+        wgpu::Texture texture = surfaceTexture.texture;
+        view = texture.createView();
+    }
 
     wgpu::RenderPassColorAttachment colorAttachment {};
-    colorAttachment.view = view;
+    colorAttachment.view = adaptiveResolution ? offscreenView : view;
     colorAttachment.depthSlice = WGPU_DEPTH_SLICE_UNDEFINED;
     colorAttachment.loadOp = wgpu::LoadOp::Clear;
     colorAttachment.storeOp = wgpu::StoreOp::Store;
@@ -387,31 +1423,229 @@ void Life::renderFrame()
     renderPassDesc.colorAttachments = &colorAttachment;
 
     wgpu::RenderPassEncoder renderPass = encoder.beginRenderPass(renderPassDesc);
-    renderPass.setPipeline(getRenderPipeline());
-    renderPass.setVertexBuffer(0, getVertexBuffer(), 0, sizeof(VERTICES));
-    
-    // Use the SAME bind group that was just written to by compute pass
-    renderPass.setBindGroup(0, currentBindGroup, 0, nullptr);
-    
-    constexpr uint32_t VERTEX_COUNT = sizeof(VERTICES) / sizeof(float) / 2;
-    renderPass.draw(VERTEX_COUNT, GRID_SIZE * GRID_SIZE, 0, 0);
+    renderPass.executeBundles(1, &cellBuffers.renderBundleFor(displayedStep));
     renderPass.end();
 
+    // ========== BLIT PASS - Upscale the offscreen frame to the surface ==========
+    if (adaptiveResolution) {
+        colorAttachment.view = view;
+        wgpu::RenderPassEncoder blitPass = encoder.beginRenderPass(renderPassDesc);
+        blitPass.setPipeline(blitPipeline);
+        blitPass.setBindGroup(0, blitBindGroup, 0, nullptr);
+        constexpr uint32_t FULLSCREEN_TRIANGLE_VERTICES = 3;
+        blitPass.draw(FULLSCREEN_TRIANGLE_VERTICES, 1, 0, 0);
+        blitPass.end();
+    }
+
+    ReadbackSlot* readback = config.headless && frameExporter ? &captureFrame(encoder) : nullptr;
+
     // Submit all commands
     wgpu::CommandBuffer commandBuffer = encoder.finish();
+    if (timeFrame) renderSubmitTime = std::chrono::steady_clock::now();
     getQueue().submit(commandBuffer);
+    if (timeFrame) finishFrameTiming();
+    if (readback) requestReadback(*readback);
+    for (CellCapture* capture : frameCaptures) requestCellMap(*capture);
+    if (frameIndex == 0) {
+        timeToFirstFrameMs = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - initializationStart).count();
+    }
+    frameIndex++;
     
-    view.release();
+    if (!config.headless) view.release();
+}
+
+void Life::createHeadlessTarget()
+{
+    wgpu::TextureDescriptor textureDesc {};
+    textureDesc.setDefault();
+    textureDesc.label = "Headless frame";
+    textureDesc.size.width = surfaceConfig.width;
+    textureDesc.size.height = surfaceConfig.height;
+    textureDesc.format = surfaceConfig.format;
+    textureDesc.usage = wgpu::TextureUsage::RenderAttachment | wgpu::TextureUsage::CopySrc;
+
+    headlessTexture = getDevice().createTexture(textureDesc);
+    if (!headlessTexture) throw Life::InitializationError("Failed to create headless frame texture");
+    headlessView = headlessTexture.createView();
+}
+
+uint32_t Life::readbackBytesPerRow() const
+{
+    // Texture to buffer copies need rows padded to 256 bytes
+    const uint32_t tightBytesPerRow = surfaceConfig.width * 4;
+    return (tightBytesPerRow + COPY_BYTES_PER_ROW_ALIGNMENT - 1) 
+        / COPY_BYTES_PER_ROW_ALIGNMENT * COPY_BYTES_PER_ROW_ALIGNMENT;
+}
+
+Life::ReadbackSlot& Life::captureFrame(const wgpu::CommandEncoder& encoder)
+{
+    auto freeSlot = [this]() -> ReadbackSlot* {
+        for (auto& slot : readbackSlots) if (!slot->inFlight) return slot.get();
+        return nullptr;
+    };
+
+    // Grow the pool while the exporter keeps up, only wait on the GPU once every slot is in flight
+    ReadbackSlot* slot = freeSlot();
+    if (!slot && readbackSlots.size() < MAX_READBACKS_IN_FLIGHT) {
+        wgpu::BufferDescriptor bufferDesc {};
+        bufferDesc.setDefault();
+        bufferDesc.label = "Frame readback";
+        bufferDesc.size = static_cast<uint64_t>(readbackBytesPerRow()) * surfaceConfig.height;
+        bufferDesc.usage = wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst;
+
+        auto newSlot = std::make_unique<ReadbackSlot>();
+        newSlot->buffer = getDevice().createBuffer(bufferDesc);
+        if (!newSlot->buffer) throw Life::RuntimeError("Failed to create frame readback buffer");
+        readbackSlots.push_back(std::move(newSlot));
+        slot = readbackSlots.back().get();
+    }
+    while (!slot) {
+        waitForEvents();
+        slot = freeSlot();
+    }
+
+    wgpu::ImageCopyTexture source {};
+    source.setDefault();
+    source.texture = headlessTexture;
+    source.mipLevel = 0;
+    source.aspect = wgpu::TextureAspect::All;
+
+    wgpu::ImageCopyBuffer destination {};
+    destination.setDefault();
+    destination.buffer = slot->buffer;
+    destination.layout.offset = 0;
+    destination.layout.bytesPerRow = readbackBytesPerRow();
+    destination.layout.rowsPerImage = surfaceConfig.height;
+
+    wgpu::Extent3D copySize {};
+    copySize.setDefault();
+    copySize.width = surfaceConfig.width;
+    copySize.height = surfaceConfig.height;
+    encoder.copyTextureToBuffer(source, destination, copySize);
+
+    slot->frameIndex = frameIndex;
+    slot->inFlight = true;
+    return *slot;
+}
+
+void Life::requestReadback(ReadbackSlot& slot)
+{
+    const uint64_t size = static_cast<uint64_t>(readbackBytesPerRow()) * surfaceConfig.height;
+    slot.mapCallback = slot.buffer.mapAsync(wgpu::MapMode::Read, 0, size, 
+        [this, &slot, size](wgpu::BufferMapAsyncStatus status) {
+            if (status != wgpu::BufferMapAsyncStatus::Success) {
+                slot.inFlight = false;
+                if (!exportFailure) {
+                    exportFailure = std::make_exception_ptr(Life::RuntimeError("Failed to map frame readback buffer"));
+                }
+                return;
+            }
+
+            // Strip the row padding, encoding happens on the exporter's threads
+            FrameExporter::Frame frame;
+            frame.index = slot.frameIndex;
+            frame.width = surfaceConfig.width;
+            frame.height = surfaceConfig.height;
+            frame.rgba.resize(static_cast<size_t>(frame.width) * frame.height * 4);
+            const auto* mapped = static_cast<const uint8_t*>(slot.buffer.getConstMappedRange(0, size));
+            const size_t tightBytesPerRow = static_cast<size_t>(frame.width) * 4;
+            for (uint32_t y = 0; y < frame.height; ++y) {
+                std::memcpy(frame.rgba.data() + y * tightBytesPerRow, 
+                            mapped + static_cast<size_t>(y) * readbackBytesPerRow(), 
+                            tightBytesPerRow);
+            }
+            slot.buffer.unmap();
+            slot.inFlight = false;
+
+            try {
+                if (frameExporter) frameExporter->submit(std::move(frame));
+            } catch (...) {
+                if (!exportFailure) exportFailure = std::current_exception();
+            }
+        });
+}
+
+void Life::flushReadbacks()
+{
+    auto anyInFlight = [this]() {
+        return std::any_of(readbackSlots.begin(), readbackSlots.end(), [](const auto& slot) { return slot->inFlight; })
+            || std::any_of(cellCaptures.begin(), cellCaptures.end(), [](const auto& capture) { return capture->inFlight; });
+    };
+    while (anyInFlight()) waitForEvents();
+    if (exportFailure) std::rethrow_exception(exportFailure);
+}
+
+void Life::waitForEvents()
+{
+    if (!Platform::canBlock()) throw Life::RuntimeError("Cannot wait for GPU callbacks on this platform");
+    Platform::processEvents(instance);
+}
+
+void Life::startFrameTiming()
+{
+    // Timestamp queries are optional, so time the render submit on the host instead: it starts once
+    // the simulation submitted before it has drained (or when submitted, if that was earlier) and ends
+    // when the queue drains again. Only one frame is measured at a time
+    frameTimingPending = true;
+    simulationDoneCallback = getQueue().onSubmittedWorkDone([this](wgpu::QueueWorkDoneStatus) {
+        renderStartTime = std::chrono::steady_clock::now();
+    });
+}
+
+void Life::finishFrameTiming()
+{
+    renderDoneCallback = getQueue().onSubmittedWorkDone([this](wgpu::QueueWorkDoneStatus status) {
+        frameTimingPending = false;
+        if (status != wgpu::QueueWorkDoneStatus::Success) return;
+        const float elapsedMs = std::chrono::duration<float, std::milli>(
+            std::chrono::steady_clock::now() - std::max(renderStartTime, renderSubmitTime)).count();
+        // Smooth out single slow frames (GC pauses, tab switches)
+        constexpr float SMOOTHING = 0.2f;
+        gpuFrameTimeMs = gpuFrameTimeMs == 0.0f
+            ? elapsedMs
+            : gpuFrameTimeMs + (elapsedMs - gpuFrameTimeMs) * SMOOTHING;
+    });
+}
+
+void Life::updateRenderScale()
+{
+    if (!adaptiveResolution || gpuFrameTimeMs == 0.0f) return;
+
+    // Only grow back well below budget so the scale doesn't oscillate around it
+    float scale = renderScale;
+    if (gpuFrameTimeMs > FRAME_TIME_BUDGET_MS) {
+        scale = std::max(MIN_RENDER_SCALE, renderScale * RENDER_SCALE_STEP);
+    } else if (gpuFrameTimeMs < FRAME_TIME_BUDGET_MS * 0.5f) {
+        scale = std::min(1.0f, renderScale / RENDER_SCALE_STEP);
+    }
+    if (scale == renderScale) return;
+
+    renderScale = scale;
+    gpuFrameTimeMs = 0.0f;
+    createOffscreenTarget();
+}
+
+void Life::setAdaptiveResolution(bool enabled)
+{
+    adaptiveResolution = enabled && !config.headless;
+    renderScale = 1.0f;
+    gpuFrameTimeMs = 0.0f;
+    // Before createResources the target is created there
+    if (buffersCreated) createOffscreenTarget();
 }
 
 void Life::handleResize()
 {
+    if (config.headless || !ready) return;
+
     int width, height;
-    emscripten_get_canvas_element_size("#canvas", &width, &height);
+    Platform::getSurfaceSize(width, height);
 
     surfaceConfig.width = static_cast<uint32_t>(width);
     surfaceConfig.height = static_cast<uint32_t>(height);
     surface.configure(surfaceConfig);
+    createOffscreenTarget();
 }
 
 bool Life::shouldUpdateCells() {
@@ -1,21 +1,86 @@
 #pragma once
 #include <cstdint>
 #include "webgpu.hpp"
+#include "Checkpoint.h"
+#include "FrameExporter.h"
+#include "History.h"
+#include "Shader.h"
+#include "Pattern.h"
+#include "PipelineCache.h"
+#include "Recorder.h"
+#include "RleCodec.h"
+#include "Simulation.h"
 #include <chrono>
+#include <exception>
+#include <memory>
+#include <vector>
 
 class Life
 {
+public:
+    // Simulation variant, every combination compiles to its own constant-folded shader (see shader.wgsl)
+    using Boundary = ::Boundary;
+    using Rule = ::Rule;
+    enum class Packing { U32, Bits }; // One cell per u32, or 32 cells per u32 along x
+
+    // Part of the grid to seed, clamped to the grid. The default covers all of it
+    struct SeedRegion {
+        uint32_t x = 0;
+        uint32_t y = 0;
+        uint32_t width = UINT32_MAX;
+        uint32_t height = UINT32_MAX;
+    };
+
+    // Startup options
+    struct Config {
+        uint32_t gridSize = 256;                 // Cells per side, bounded by the device's storage buffer limits
+        Rule rule {};                            // B3/S23 (Conway) by default
+        Boundary boundary = Boundary::Torus;
+        Packing packing = Packing::U32;
+        uint32_t workgroupSize = 8;              // Compute tile edge
+        // Simulation steps dispatched per update. A frame renders the generation that was current before
+        // its compute work, so the ring needs stepsPerUpdate + 1 buffers to show the right generation, and
+        // 2 * stepsPerUpdate + 1 so that the next update's compute never writes the buffer still being drawn
+        // (letting the two overlap)
+        uint32_t stepsPerUpdate = 1;
+        uint32_t stateRingDepth = 3;             // State buffers in the ring, at least stepsPerUpdate + 1
+        uint64_t seed = 0;                       // Initial soup, 0 picks one at random (see getConfig)
+        float density = 0.5f;                    // Share of active cells in the initial soup
+        bool seedOnCpu = false;                  // Generate the (identical) soup on the host instead of the seeding pass
+        std::shared_ptr<const Pattern::Runs> pattern; // Decoded on the GPU, centered on an empty grid instead of the soup
+        // Resumed instead of the soup or pattern, its grid size, rule, boundary and seed replace the ones above
+        std::shared_ptr<const Checkpoint> checkpoint;
+        size_t historyBudget = 32ull << 20;      // Bytes of rewind history (see History), 0 stops recording it.
+                                                 // Includes the grids it keeps resident (getHistoryResidentSize),
+                                                 // grids whose copies take over half of it get no history
+        bool adaptiveResolution = false; // Trade render resolution for frame time (see setAdaptiveResolution)
+        bool headless = false;      // Render into an offscreen texture instead of the #canvas surface
+        uint32_t frameWidth = 1024; // Headless frame size, the canvas size is used otherwise
+        uint32_t frameHeight = 1024;
+        bool forceFallbackAdapter = false; // Software adapter (SwiftShader, lavapipe) for GPU-less machines
+    };
+
 private:
     // WGPU Context
-    struct PingPongBuffers {
-        wgpu::Buffer read{};
-        wgpu::Buffer write{};
-        wgpu::BindGroup readBindGroup{};
-        wgpu::BindGroup writeBindGroup{};
-        
-        void swap() {
-            std::swap(read, write);
-            std::swap(readBindGroup, writeBindGroup);
+    // Ring of cell state buffers, one per in-flight generation.
+    // Generation g lives in buffers[g % depth()]. computeBindGroups[i] reads buffers[i] and
+    // writes buffers[(i + 1) % depth()], renderBindGroups[i] only reads buffers[i].
+    // renderBundles[i] holds the pre-recorded draw of buffers[i].
+    struct CellBufferRing {
+        std::vector<wgpu::Buffer> buffers;
+        std::vector<wgpu::BindGroup> computeBindGroups;
+        std::vector<wgpu::BindGroup> renderBindGroups;
+        std::vector<wgpu::RenderBundle> renderBundles;
+
+        uint32_t depth() const { return static_cast<uint32_t>(buffers.size()); }
+        const wgpu::BindGroup& computeBindGroupFor(uint64_t generation) const {
+            return computeBindGroups[generation % depth()];
+        }
+        const wgpu::BindGroup& renderBindGroupFor(uint64_t generation) const {
+            return renderBindGroups[generation % depth()];
+        }
+        const wgpu::RenderBundle& renderBundleFor(uint64_t generation) const {
+            return renderBundles[generation % depth()];
         }
     };
     
@@ -27,46 +92,184 @@ private:
     wgpu::SurfaceConfiguration surfaceConfig{};
     wgpu::RenderPipeline renderPipeline{nullptr};
     wgpu::ComputePipeline simulationPipeline{nullptr};
-    wgpu::Buffer vertexBuffer{nullptr};
     wgpu::Buffer uniformBuffer{nullptr};
-    PingPongBuffers cellBuffers;
+    CellBufferRing cellBuffers;
     wgpu::BindGroupLayout bindGroupLayout{nullptr};
+    wgpu::BindGroupLayout renderBindGroupLayout{nullptr};
     wgpu::BindGroup bindGroup{nullptr};
 
-    // Geometry
-    static constexpr float VERTICES[] = {
-        -0.8f, -0.8f,
-         0.8f, -0.8f,
-         0.8f,  0.8f,
-        
-        -0.8f, -0.8f,
-         0.8f,  0.8f,
-        -0.8f,  0.8f,
+    // Adaptive resolution: cells are drawn into a texture of at most CELL_PIXELS per cell and upscaled to the surface
+    wgpu::Texture offscreenTexture{nullptr};
+    wgpu::TextureView offscreenView{nullptr};
+    wgpu::RenderPipeline blitPipeline{nullptr};
+    wgpu::BindGroupLayout blitBindGroupLayout{nullptr};
+    wgpu::BindGroup blitBindGroup{nullptr};
+
+    // GPU seeding (seed.wgsl), the uniform mirrors SeedParams in the shader
+    struct SeedParams {
+        uint32_t key[2];
+        uint32_t rectMin[2];
+        uint32_t rectMax[2];
+        uint32_t width;
+        uint32_t threshold;
+    };
+    static_assert(sizeof(SeedParams) == 32, "SeedParams must match the WGSL struct layout");
+    wgpu::ComputePipeline seedPipeline{nullptr};
+    wgpu::BindGroupLayout seedBindGroupLayout{nullptr};
+    wgpu::Buffer seedParamsBuffer{nullptr};
+
+    // Readbacks of Packing::U32 grids are bitpacked on the GPU first (pack.wgsl), into packedCells.
+    // packBindGroups[i] packs ring slot i
+    wgpu::ComputePipeline packPipeline{nullptr};
+    wgpu::BindGroupLayout packBindGroupLayout{nullptr};
+    wgpu::Buffer packedCells{nullptr};
+    std::vector<wgpu::BindGroup> packBindGroups;
+
+    // Pattern upload and export as run lengths (rle.wgsl, scan.wgsl)
+    std::unique_ptr<RleCodec> rleCodec;
+
+    // Headless rendering: frames are drawn into headlessTexture and, with an exporter attached,
+    // copied into a small pool of mappable buffers that are read back without waiting on the GPU
+    struct ReadbackSlot {
+        wgpu::Buffer buffer{nullptr};
+        uint64_t frameIndex = 0;
+        bool inFlight = false;
+        std::unique_ptr<wgpu::BufferMapCallback> mapCallback;
     };
-    static constexpr int GRID_SIZE = 256;
-    static constexpr int WORKGROUP_SIZE = 8;
-    static constexpr float GRID_DIMENSIONS[2] = {
-        static_cast<float>(GRID_SIZE), 
-        static_cast<float>(GRID_SIZE)
+    static constexpr size_t MAX_READBACKS_IN_FLIGHT = 4;
+    static constexpr uint32_t COPY_BYTES_PER_ROW_ALIGNMENT = 256;
+    wgpu::Texture headlessTexture{nullptr};
+    wgpu::TextureView headlessView{nullptr};
+    std::vector<std::unique_ptr<ReadbackSlot>> readbackSlots;
+    FrameExporter* frameExporter = nullptr;
+    std::exception_ptr exportFailure;
+    uint64_t frameIndex = 0;
+
+    // Rewind history and recording: every new generation, including those an update of several steps
+    // passes over, is copied, bitpacked, into one of a few mappable buffers and, once mapped, pushed into history and submitted to the recorder. Captures
+    // still in flight when the grid is replaced (a rewind, a new seed) belong to an older historyEpoch
+    // and are kept out of history. Without a recorder a capture finding every buffer busy leaves a gap,
+    // which starts the history over. With one it waits, since a recording can't skip generations
+    struct CellCapture {
+        wgpu::Buffer buffer{nullptr};
+        uint64_t generation = 0;
+        uint64_t epoch = 0;
+        bool inFlight = false;
+        std::unique_ptr<wgpu::BufferMapCallback> mapCallback;
     };
+    static constexpr size_t MAX_CELL_CAPTURES_IN_FLIGHT = 4; // More when the state ring is deeper (cellCaptureLimit)
+    std::unique_ptr<History> history;
+    std::vector<std::unique_ptr<CellCapture>> cellCaptures;
+    std::vector<CellCapture*> frameCaptures; // Recorded by this frame, mapped once it is submitted
+    uint64_t historyEpoch = 0;
+    uint64_t lastCapturedGeneration = UINT64_MAX; // Paused redraws show it again and aren't captured
+    Recorder* cellRecorder = nullptr;
+    bool paused = false;
+    bool redrawPending = false; // Paused, draw once after a rewind
+    bool stepPending = false;   // Paused, advance one generation on the next frame
+
+    static constexpr uint64_t GRID_UNIFORM_SIZE = 2 * sizeof(float); // vec2f grid dimensions
+    // The initial state is written into a buffer mapped at creation. Emscripten backs mapped ranges
+    // with a heap copy, so there grids past MAX_MAPPED_UPLOAD_SIZE are uploaded 256KB at a time instead
+#ifdef __EMSCRIPTEN__
+    static constexpr uint64_t MAX_MAPPED_UPLOAD_SIZE = 32ull << 20;
+#else
+    static constexpr uint64_t MAX_MAPPED_UPLOAD_SIZE = UINT64_MAX;
+#endif
+    static constexpr size_t UPLOAD_CHUNK_WORDS = 1 << 16;
+    uint64_t maxStateBufferSize = 0;
+
+    // Steps recorded into one command buffer by simulate()
+    static constexpr uint32_t SIMULATE_BATCH_STEPS = 256;
+
+    // Adaptive resolution, the render scale shrinks while the measured GPU frame time (render and blit
+    // passes only, the simulation doesn't get cheaper at a lower scale) exceeds the budget and recovers
+    // once it is comfortably below it
+    // At full scale the offscreen target keeps CELL_PIXELS per cell, enough for the gaps between cells
+    // (CELL_MARGIN in shader.wgsl). Scaled down, it never drops below one pixel per cell
+    static constexpr uint32_t CELL_PIXELS = 8;
+    static constexpr float FRAME_TIME_BUDGET_MS = 8.0f;
+    static constexpr float MIN_RENDER_SCALE = 0.125f;
+    static constexpr float RENDER_SCALE_STEP = 0.8f;
+    bool adaptiveResolution = false;
+    float renderScale = 1.0f;
+    float gpuFrameTimeMs = 0.0f;
+    bool frameTimingPending = false;
+    std::chrono::steady_clock::time_point renderSubmitTime;
+    std::chrono::steady_clock::time_point renderStartTime;
+    std::unique_ptr<wgpu::QueueWorkDoneCallback> simulationDoneCallback;
+    std::unique_ptr<wgpu::QueueWorkDoneCallback> renderDoneCallback;
+
+    Config config;
+
+    // Asynchronous initialization, the request handles must outlive their callbacks
+    std::unique_ptr<wgpu::RequestAdapterCallback> adapterRequest;
+    std::unique_ptr<wgpu::RequestDeviceCallback> deviceRequest;
+    static constexpr int PIPELINE_COUNT = 6; // Render, simulation, blit, seeding, run-length codec and packing (U32 only)
+    int pendingPipelines = 0;
+    bool buffersCreated = false;
+    std::exception_ptr initializationFailure;
+    bool ready = false;
+    std::chrono::steady_clock::time_point initializationStart;
+    float timeToFirstFrameMs = 0.0f;
+
+    // Owns every pipeline, layout and shader module, so reconfiguring back to a variant seen before
+    // swaps pipelines without compiling. simulationPipelineKey is the variant that was asked for last,
+    // simulationWorkgroupSize the tile size of the one currently bound
+    std::unique_ptr<PipelineCache> pipelineCache;
+    PipelineCache::Key simulationPipelineKey = 0;
+    uint32_t simulationWorkgroupSize = 0;
+    std::exception_ptr pipelineFailure;
 
     // Cell State
     static constexpr float UPDATE_INTERVAL_SECONDS = 0.1f;
-    std::vector<uint32_t> cellStateArray;
     float accumulatedTime = UPDATE_INTERVAL_SECONDS;
     std::chrono::steady_clock::time_point lastFrameTime;
-    uint32_t step = 0;
+    uint64_t step = 0;  // Steps since the grid was created, 64-bit so that step % depth never wraps
+    uint64_t generationOffset = 0; // Generation of step 0, set by restoring a checkpoint
     
+    void createInstance();
     void requestAdapter();
     void requestDevice();
+    void failInitialization(const std::string& what, const char* message);
+    void createResources();
+    void onPipelineCreated();
+    void finishInitialization();
     void createSurface();
     void configureSurface();
     void createPipelines();
-    void createVertexBuffer();
+    void requestSimulationPipeline();
     void createUniformBuffer();
     void createStorageBuffers();
+    void generateInitialState(uint32_t* words, uint64_t firstWord, size_t count) const;
     void createBindGroupLayout();
-    void createBindGroup();
+    void createBindGroups();
+    void createRenderBundles();
+    uint32_t stateColumns() const;
+    uint64_t stateBufferSize() const;
+    uint64_t packedStateSize() const;
+    Shader::Defines shaderDefines() const;
+    Shader::Defines renderShaderDefines() const;
+    void createBlitPipeline();
+    void createSeedPipeline();
+    void createPackPipeline();
+    void createRleCodec();
+    void createOffscreenTarget();
+    void startFrameTiming();
+    void finishFrameTiming();
+    void updateRenderScale();
+    void createHeadlessTarget();
+    uint32_t readbackBytesPerRow() const;
+    ReadbackSlot& captureFrame(const wgpu::CommandEncoder& encoder);
+    void requestReadback(ReadbackSlot& slot);
+    void waitForEvents();
+    void uploadCells(const uint32_t* words, uint32_t firstRow, uint32_t rowCount);
+    void copyPackedCells(const wgpu::CommandEncoder& encoder, uint64_t stateStep, const wgpu::Buffer& target);
+    size_t cellCaptureLimit() const;
+    void captureCells(const wgpu::CommandEncoder& encoder, uint64_t displayedStep);
+    CellCapture* captureCell(const wgpu::CommandEncoder& encoder, uint64_t capturedStep);
+    void requestCellMap(CellCapture& capture);
+    void resetHistory();
     void cleanup();
     bool shouldUpdateCells();
 
@@ -81,7 +284,10 @@ public:
             RuntimeError(const std::string& msg) 
                 : std::runtime_error("Encountered an unexpected runtime error: " + msg) {}
     };
+    // Construction only starts initialization, renderFrame does nothing until isReady()
+    // and rethrows any InitializationError raised along the way
     Life();
+    explicit Life(const Config& config);
     ~Life();
 
     const wgpu::Instance& getInstance() const { return instance; }
@@ -92,12 +298,88 @@ public:
     const wgpu::SurfaceConfiguration& getSurfaceConfig() const { return surfaceConfig; }
     const wgpu::RenderPipeline& getRenderPipeline() const { return renderPipeline; }
     const wgpu::ComputePipeline& getSimulationPipeline() const { return simulationPipeline; }
-    const wgpu::Buffer& getVertexBuffer() const { return vertexBuffer; }
     const wgpu::Buffer& getUniformBuffer() const { return uniformBuffer; }
     const wgpu::BindGroupLayout& getBindGroupLayout() const { return bindGroupLayout; }
+    const wgpu::BindGroupLayout& getRenderBindGroupLayout() const { return renderBindGroupLayout; }
     const wgpu::BindGroup& getBindGroup() const { return bindGroup; }
+    bool isReady() const { return ready; }
+    // Construction until the first submitted frame, 0 before that
+    float getTimeToFirstFrameMs() const { return timeToFirstFrameMs; }
     void renderFrame();
     void handleResize();
+    // Off by default (Config::adaptiveResolution), and always off headless since frames are exported
+    // at full resolution
+    void setAdaptiveResolution(bool enabled);
+    bool isAdaptiveResolution() const { return adaptiveResolution; }
+    float getRenderScale() const { return renderScale; }
+    float getGpuFrameTimeMs() const { return gpuFrameTimeMs; }
+
+    // Overwrites the region of the displayed generation with a fresh soup, computed on the GPU from
+    // the seed alone (no upload). The same seed, density and grid always produce the same cells
+    void seed(uint64_t seed, float density, const SeedRegion& region = {});
+
+    // Clears the displayed generation and places the pattern with the bottom left of its bounding
+    // box at (x, y), clipped to the grid. Pattern rows run top down, so its first row lands on the
+    // highest grid row. Only the rows the pattern covers are uploaded
+    void loadPattern(const Pattern& pattern, uint32_t x, uint32_t y);
+    // Same placement as loadPattern, but only the run lengths are uploaded and the cells are decoded
+    // on the GPU, so even huge sparse patterns cost a few bytes per run
+    void loadRuns(const Pattern::Runs& runs, uint32_t x, uint32_t y);
+    // Encodes the displayed generation (the whole grid, with the current rule) on the GPU and reads back
+    // only the run boundaries. done runs from the event loop, one encode at a time
+    void encodeRuns(RleCodec::Encoded&& done);
+    // encodeRuns, blocking until the runs arrive (native only)
+    Pattern::Runs readRuns();
+
+    // Overwrites the displayed generation with a checkpoint of the same grid size and continues
+    // counting from its generation. Bitpacked state uploads uncompressed tiles straight from the mapping
+    void restoreCheckpoint(const Checkpoint& checkpoint);
+    // Reads the displayed generation back and saves it, blocking until written (native only)
+    void saveCheckpoint(const std::string& path, bool compress = true);
+    // Reads the displayed generation back bitpacked (32 cells per word, row y = 0 first), whatever
+    // the packing, blocking until it arrives (native only)
+    void readCells(std::vector<uint32_t>& words);
+    // Overwrites the displayed generation with bitpacked cells in the layout readCells returns and
+    // continues counting from generation
+    void setCells(const uint32_t* words, uint64_t generation);
+    uint64_t getGeneration() const { return generationOffset + step; }
+
+    // Blocks until the device, pipelines and initial grid are ready (native only)
+    void waitUntilReady();
+    // Advances generations without drawing, blocking until the GPU has finished them (native only).
+    // Steps go out in batches of SIMULATE_BATCH_STEPS, the next one recorded while the last one runs
+    void simulate(uint64_t generations);
+
+    // Rewind, empty when Config::historyBudget is 0 or too small for the grid. Paused, frames keep drawing the same generation
+    void setPaused(bool paused);
+    bool isPaused() const { return paused; }
+    const History* getHistory() const { return history.get(); }
+    // Bytes history keeps besides its change sets: its own grid and scratch copy, the capture buffers
+    // and the packing target. Counted against Config::historyBudget
+    uint64_t getHistoryResidentSize() const;
+    // Replaces the displayed generation with one from the history, the run continues from there and
+    // the generations after it are dropped once it does
+    void rewind(uint64_t generation);
+    // Pause and move one generation, forward through the history first and simulating past its end
+    void stepBackward();
+    void stepForward();
+
+    // Switches rule, boundary and tile size while keeping the cell state. Variants used before swap in
+    // on the next frame, new ones compile in the background while the current one keeps running.
+    // Packing changes the buffer layout and stays fixed for the lifetime of Life
+    void setSimulation(const Rule& rule, Boundary boundary, uint32_t workgroupSize);
+    const Config& getConfig() const { return config; }
+    const PipelineCache* getPipelineCache() const { return pipelineCache.get(); }
+
+    // Headless only, every rendered frame is handed to the exporter (not owned, must outlive Life)
+    void setFrameExporter(FrameExporter* exporter) { frameExporter = exporter; }
+    // Every generation displayed from the next frame on is read back without stalling the frame and
+    // submitted to the recorder, whose firstGeneration must be getGeneration() (not owned, must outlive Life)
+    void setCellRecorder(Recorder* recorder) { cellRecorder = recorder; }
+    // Blocks until every frame and generation read back so far has been passed to the exporter and
+    // recorder, rethrowing the first error of either
+    void flushReadbacks();
+    bool isHeadless() const { return config.headless; }
 
 };
 
@@ -0,0 +1,47 @@
+#include "MappedFile.h"
+#include <fstream>
+
+#if !defined(__EMSCRIPTEN__) && (defined(__unix__) || defined(__APPLE__))
+#define LIFE_MMAP 1
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path, bool willNeed)
+{
+#if LIFE_MMAP
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw FileError("Failed to open " + path);
+    struct stat info {};
+    if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+        void* data = ::mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data != MAP_FAILED) {
+            if (willNeed) ::madvise(data, static_cast<size_t>(info.st_size), MADV_WILLNEED);
+            mapped = data;
+            mappedSize = static_cast<size_t>(info.st_size);
+            text = std::string_view(static_cast<const char*>(data), mappedSize);
+        }
+    }
+    ::close(fd);
+    if (mapped || info.st_size == 0) return;
+#else
+    (void)willNeed;
+#endif
+    std::ifstream stream(path, std::ios::binary | std::ios::ate);
+    if (!stream) throw FileError("Failed to open " + path);
+    buffer.resize(static_cast<size_t>(stream.tellg()));
+    stream.seekg(0);
+    if (!stream.read(buffer.data(), static_cast<std::streamsize>(buffer.size()))) {
+        throw FileError("Failed to read " + path);
+    }
+    text = buffer;
+}
+
+MappedFile::~MappedFile()
+{
+#if LIFE_MMAP
+    if (mapped) ::munmap(mapped, mappedSize);
+#endif
+}
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+// Read-only view of a whole file. Memory mapped on native unix builds, so the pages are only faulted
+// in once read and can be handed to the GPU upload or a parser without an intermediate copy. Elsewhere
+// (the web, Windows) the file is read into memory instead
+class MappedFile
+{
+public:
+    class FileError : public std::runtime_error {
+        public:
+            FileError(const std::string& msg)
+                : std::runtime_error("File access failed: " + msg) {}
+    };
+
+    // willNeed asks the kernel to read the whole file ahead, for callers that scan all of it
+    explicit MappedFile(const std::string& path, bool willNeed = true);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const std::byte* data() const { return reinterpret_cast<const std::byte*>(text.data()); }
+    size_t size() const { return text.size(); }
+    std::string_view getText() const { return text; }
+    bool isMapped() const { return mapped != nullptr; }
+
+private:
+    std::string_view text;
+    std::string buffer;
+    void* mapped = nullptr;
+    size_t mappedSize = 0;
+};
@@ -0,0 +1,651 @@
+#include "Pattern.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Smaller inputs are parsed on the calling thread, spawning threads would cost more than it saves
+constexpr size_t MIN_CHUNK_BYTES = 1 << 20;
+
+unsigned resolveThreadCount(unsigned threadCount)
+{
+    if (threadCount > 0) return threadCount;
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+    return 1;
+#else
+    return std::max(1u, std::thread::hardware_concurrency());
+#endif
+}
+
+// Calls work(i) for every i in [0, count) on up to threadCount threads including the caller,
+// rethrows the first error
+void runParallel(size_t count, unsigned threadCount, const std::function<void(size_t)>& work)
+{
+    std::atomic<size_t> next { 0 };
+    std::atomic<bool> failed { false };
+    std::exception_ptr error;
+    const auto drain = [&]() {
+        for (size_t i = next++; i < count && !failed; i = next++) {
+            try {
+                work(i);
+            } catch (...) {
+                if (!failed.exchange(true)) error = std::current_exception();
+            }
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (size_t i = 1; i < std::min<size_t>(threadCount, count); ++i) threads.emplace_back(drain);
+    drain();
+    for (auto& thread : threads) thread.join();
+    if (error) std::rethrow_exception(error);
+}
+
+// Splits text into up to threadCount chunks of at least MIN_CHUNK_BYTES, each ending right after a
+// delimiter so no row (or RLE run) straddles two chunks
+std::vector<std::string_view> splitChunks(std::string_view text, char delimiter, unsigned threadCount)
+{
+    const size_t count = std::clamp<size_t>(text.size() / MIN_CHUNK_BYTES, 1, threadCount);
+    std::vector<std::string_view> chunks;
+    size_t begin = 0;
+    for (size_t i = 1; i <= count && begin < text.size(); ++i) {
+        size_t end = text.size();
+        if (i < count) {
+            end = text.find(delimiter, std::max(begin, text.size() / count * i));
+            end = end == std::string_view::npos ? text.size() : end + 1;
+        }
+        chunks.push_back(text.substr(begin, end - begin));
+        begin = end;
+    }
+    return chunks;
+}
+
+// Calls line(text) for every line of the chunk, without its line break
+template <typename Line>
+void forEachLine(std::string_view chunk, Line&& line)
+{
+    while (!chunk.empty()) {
+        const size_t end = chunk.find('\n');
+        std::string_view text = chunk.substr(0, end);
+        if (!text.empty() && text.back() == '\r') text.remove_suffix(1);
+        line(text);
+        if (end == std::string_view::npos) break;
+        chunk.remove_prefix(end + 1);
+    }
+}
+
+std::string_view trim(std::string_view text)
+{
+    const size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) return {};
+    return text.substr(begin, text.find_last_not_of(" \t\r\n") - begin + 1);
+}
+
+// RLE rules come as B3/S23 or S/B (23/3), optionally with a :T bounded grid suffix, which is ignored
+Rule parseRleRule(std::string_view text)
+{
+    std::string rule { text.substr(0, text.find(':')) };
+    try {
+        if (rule.find_first_of("BbSs") == std::string::npos) {
+            const size_t slash = rule.find('/');
+            if (slash == std::string::npos) throw std::invalid_argument("Rule expects B/S notation, got " + rule);
+            rule = "B" + rule.substr(slash + 1) + "/S" + rule.substr(0, slash);
+        }
+        return Rule::parse(rule);
+    } catch (const std::invalid_argument& e) {
+        throw Pattern::ParseError(e.what());
+    }
+}
+
+uint32_t parseDimension(std::string_view text, const char* name)
+{
+    uint32_t value = 0;
+    const auto result = std::from_chars(text.data(), text.data() + text.size(), value);
+    if (result.ec != std::errc() || result.ptr != text.data() + text.size()) {
+        throw Pattern::ParseError(std::string("Invalid RLE ") + name + " '" + std::string(text) + "'");
+    }
+    return value;
+}
+
+// Walks RLE data that starts on row firstRow, calls live(x, y, count) for every run of live cells and
+// returns the number of rows the data ends ('$' with their run counts)
+template <typename Live>
+uint64_t walkRle(std::string_view data, uint32_t width, uint32_t height, uint64_t firstRow, Live&& live)
+{
+    uint64_t rows = 0;
+    uint64_t x = 0;
+    uint64_t count = 0;
+    for (const char c : data) {
+        if (c >= '0' && c <= '9') {
+            count = count * 10 + static_cast<uint64_t>(c - '0');
+            if (count > std::numeric_limits<uint32_t>::max()) throw Pattern::ParseError("RLE run count out of range");
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r' || c == '\n') continue;
+
+        const uint64_t run = count > 0 ? count : 1;
+        count = 0;
+        if (c == '$') {
+            rows += run;
+            x = 0;
+        } else if (c == 'b' || c == '.') {
+            x += run;
+        } else if ((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z')) {
+            // o, or any state of a multistate pattern
+            const uint64_t y = firstRow + rows;
+            if (y >= height || x + run > width) {
+                throw Pattern::ParseError("Cells outside the x = " + std::to_string(width)
+                    + ", y = " + std::to_string(height) + " bounds of the RLE header");
+            }
+            live(static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(run));
+            x += run;
+        } else {
+            throw Pattern::ParseError(std::string("Unexpected character '") + c + "' in RLE data");
+        }
+    }
+    return rows;
+}
+
+// Rows ended by a chunk of RLE data, only looks at the '$' runs so it scans at memchr speed
+uint64_t countRleRows(std::string_view data)
+{
+    uint64_t rows = 0;
+    for (size_t end = data.find('$'); end != std::string_view::npos; end = data.find('$', end + 1)) {
+        size_t digits = end;
+        while (digits > 0 && (data[digits - 1] == ' ' || data[digits - 1] == '\t' || data[digits - 1] == '\r' || data[digits - 1] == '\n')) --digits;
+        const size_t countEnd = digits;
+        while (digits > 0 && data[digits - 1] >= '0' && data[digits - 1] <= '9') --digits;
+        uint64_t count = 1;
+        if (digits < countEnd) std::from_chars(data.data() + digits, data.data() + countEnd, count);
+        rows += count;
+    }
+    return rows;
+}
+
+struct RleHeader {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::optional<Rule> rule;
+    std::string_view data; // Run data up to the terminating '!'
+};
+
+// #-comments, then the "x = m, y = n[, rule = r]" header line, then the run data
+RleHeader readRleHeader(std::string_view text)
+{
+    size_t offset = 0;
+    std::string_view line;
+    while (offset < text.size() && line.empty()) {
+        size_t end = text.find('\n', offset);
+        if (end == std::string_view::npos) end = text.size();
+        line = trim(text.substr(offset, end - offset));
+        offset = std::min(text.size(), end + 1);
+        if (!line.empty() && line[0] == '#') line = {};
+    }
+    if (line.empty() || line[0] != 'x') throw Pattern::ParseError("Missing RLE header line");
+
+    RleHeader header;
+    bool hasWidth = false;
+    bool hasHeight = false;
+    while (!line.empty()) {
+        const size_t comma = line.find(',');
+        const std::string_view field = line.substr(0, comma);
+        line = comma == std::string_view::npos ? std::string_view() : line.substr(comma + 1);
+        const size_t equals = field.find('=');
+        if (equals == std::string_view::npos) throw Pattern::ParseError("Invalid RLE header field '" + std::string(field) + "'");
+        const std::string_view key = trim(field.substr(0, equals));
+        const std::string_view value = trim(field.substr(equals + 1));
+        if (key == "x") {
+            header.width = parseDimension(value, "width");
+            hasWidth = true;
+        } else if (key == "y") {
+            header.height = parseDimension(value, "height");
+            hasHeight = true;
+        } else if (key == "rule") {
+            header.rule = parseRleRule(value);
+        }
+    }
+    if (!hasWidth || !hasHeight) throw Pattern::ParseError("RLE header needs both x and y");
+
+    header.data = text.substr(offset);
+    header.data = header.data.substr(0, header.data.find('!'));
+    return header;
+}
+
+// Splits RLE data into chunks that start on a row, and finds the first row of each
+void splitRleRows(std::string_view data, unsigned threadCount, std::vector<std::string_view>& chunks, std::vector<uint64_t>& firstRows)
+{
+    chunks = splitChunks(data, '$', threadCount);
+    std::vector<uint64_t> rowCounts(chunks.size());
+    runParallel(chunks.size(), threadCount, [&](size_t i) { rowCounts[i] = countRleRows(chunks[i]); });
+    firstRows.assign(chunks.size() + 1, 0);
+    for (size_t i = 0; i < chunks.size(); ++i) firstRows[i + 1] = firstRows[i] + rowCounts[i];
+}
+
+bool isPlaintextCell(char c)
+{
+    return c == 'O' || c == 'o' || c == '*';
+}
+
+// Life 1.06 coordinates, "x y" per line
+bool parseCoordinates(std::string_view line, int64_t& x, int64_t& y)
+{
+    const char* p = line.data();
+    const char* end = line.data() + line.size();
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    auto result = std::from_chars(p, end, x);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    result = std::from_chars(p, end, y);
+    if (result.ec != std::errc()) return false;
+    p = result.ptr;
+    while (p < end && (*p == ' ' || *p == '\t')) ++p;
+    return p == end;
+}
+
+// Runs are indexed with 32-bit cell positions on the GPU
+void checkRunsFit(uint32_t width, uint32_t height)
+{
+    if (static_cast<uint64_t>(width) * height > std::numeric_limits<uint32_t>::max()) {
+        throw Pattern::ParseError("A " + std::to_string(width) + "x" + std::to_string(height)
+            + " pattern has too many cells for run lengths");
+    }
+}
+
+} // namespace
+
+Pattern::Pattern(uint32_t width, uint32_t height)
+{
+    allocate(width, height);
+    std::fill(words.get(), words.get() + static_cast<size_t>(wordsPerRow) * height, 0u);
+}
+
+void Pattern::allocate(uint32_t width, uint32_t height)
+{
+    this->width = width;
+    this->height = height;
+    wordsPerRow = (width + 31) / 32;
+    words.reset(new uint32_t[static_cast<size_t>(wordsPerRow) * height]);
+}
+
+Pattern Pattern::load(const std::string& path, unsigned threadCount)
+{
+    const MappedFile file(path);
+    return parse(file.getText(), detectFormat(path, file.getText()), threadCount);
+}
+
+Pattern::Format Pattern::detectFormat(const std::string& path, std::string_view text)
+{
+    std::string extension = path.substr(std::min(path.size(), path.rfind('.')));
+    std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) {
+        return static_cast<char>(std::tolower(c));
+    });
+    if (extension == ".rle") return Format::Rle;
+    if (extension == ".cells") return Format::Plaintext;
+    if (extension == ".lif" || extension == ".life") return Format::Life106;
+
+    if (text.substr(0, 10) == "#Life 1.06") return Format::Life106;
+    // The first line that isn't a comment is the RLE header, or already a row of cells
+    Format format = Format::Plaintext;
+    forEachLine(text.substr(0, MIN_CHUNK_BYTES), [&](std::string_view line) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#' || line[0] == '!' || format == Format::Rle) return;
+        if (line[0] == 'x') format = Format::Rle;
+    });
+    return format;
+}
+
+Pattern Pattern::parse(std::string_view text, Format format, unsigned threadCount)
+{
+    threadCount = resolveThreadCount(threadCount);
+    switch (format) {
+    case Format::Rle: return parseRle(text, threadCount);
+    case Format::Plaintext: return parsePlaintext(text, threadCount);
+    case Format::Life106: return parseLife106(text, threadCount);
+    }
+    throw ParseError("Unknown pattern format");
+}
+
+Pattern Pattern::parseRle(std::string_view text, unsigned threadCount)
+{
+    const RleHeader header = readRleHeader(text);
+    Pattern pattern;
+    pattern.rule = header.rule;
+    pattern.allocate(header.width, header.height);
+
+    // Chunks start on a row, so the rows each one ends give every chunk its first row
+    std::vector<std::string_view> chunks;
+    std::vector<uint64_t> firstRows;
+    splitRleRows(header.data, threadCount, chunks, firstRows);
+
+    // Each chunk clears and fills the rows it owns, the last one also clears the rows after the data
+    runParallel(chunks.size(), threadCount, [&](size_t i) {
+        const uint64_t beginRow = std::min<uint64_t>(firstRows[i], pattern.height);
+        const uint64_t endRow = i + 1 == chunks.size() ? pattern.height : std::min<uint64_t>(firstRows[i + 1], pattern.height);
+        uint32_t* begin = pattern.row(static_cast<uint32_t>(beginRow));
+        std::fill(begin, begin + (endRow - beginRow) * pattern.wordsPerRow, 0u);
+        const uint64_t rows = walkRle(chunks[i], pattern.width, pattern.height, firstRows[i],
+            [&pattern](uint32_t x, uint32_t y, uint32_t count) { pattern.setRun(x, y, count); });
+        if (rows != firstRows[i + 1] - firstRows[i]) throw ParseError("Malformed RLE row counts");
+    });
+    return pattern;
+}
+
+Pattern::Runs Pattern::loadRuns(const std::string& path, unsigned threadCount)
+{
+    const MappedFile file(path);
+    if (detectFormat(path, file.getText()) == Format::Rle) return readRuns(file.getText(), threadCount);
+    return load(path, threadCount).toRuns();
+}
+
+Pattern::Runs Pattern::readRuns(std::string_view rleText, unsigned threadCount)
+{
+    threadCount = resolveThreadCount(threadCount);
+    const RleHeader header = readRleHeader(rleText);
+    checkRunsFit(header.width, header.height);
+    Runs runs;
+    runs.width = header.width;
+    runs.height = header.height;
+    runs.rule = header.rule;
+
+    std::vector<std::string_view> chunks;
+    std::vector<uint64_t> firstRows;
+    splitRleRows(header.data, threadCount, chunks, firstRows);
+
+    // Every chunk collects its own runs, starting with the dead cells from its first row on, then
+    // they are stitched together with live runs that touch across chunks merged
+    struct Fragment {
+        std::vector<uint32_t> lengths;
+        uint64_t end = 0; // Cell after the last live run
+    };
+    std::vector<Fragment> fragments(chunks.size());
+    runParallel(chunks.size(), threadCount, [&](size_t i) {
+        Fragment& fragment = fragments[i];
+        fragment.end = firstRows[i] * header.width;
+        const uint64_t rows = walkRle(chunks[i], header.width, header.height, firstRows[i],
+            [&](uint32_t x, uint32_t y, uint32_t count) {
+                const uint64_t cell = static_cast<uint64_t>(y) * header.width + x;
+                if (!fragment.lengths.empty() && cell == fragment.end) {
+                    fragment.lengths.back() += count;
+                } else {
+                    fragment.lengths.push_back(static_cast<uint32_t>(cell - fragment.end));
+                    fragment.lengths.push_back(count);
+                }
+                fragment.end = cell + count;
+            });
+        if (rows != firstRows[i + 1] - firstRows[i]) throw ParseError("Malformed RLE row counts");
+    });
+
+    uint64_t end = 0;
+    for (size_t i = 0; i < fragments.size(); ++i) {
+        const Fragment& fragment = fragments[i];
+        if (fragment.lengths.empty()) continue;
+        const uint64_t firstLive = firstRows[i] * header.width + fragment.lengths[0];
+        if (!runs.lengths.empty() && firstLive == end) {
+            runs.lengths.back() += fragment.lengths[1];
+            runs.lengths.insert(runs.lengths.end(), fragment.lengths.begin() + 2, fragment.lengths.end());
+        } else {
+            runs.lengths.push_back(static_cast<uint32_t>(firstLive - end));
+            runs.lengths.insert(runs.lengths.end(), fragment.lengths.begin() + 1, fragment.lengths.end());
+        }
+        end = fragment.end;
+    }
+    return runs;
+}
+
+Pattern Pattern::fromRuns(const Runs& runs)
+{
+    checkRunsFit(runs.width, runs.height);
+    Pattern pattern(runs.width, runs.height);
+    pattern.rule = runs.rule;
+    uint64_t cell = 0;
+    const uint64_t cellCount = static_cast<uint64_t>(runs.width) * runs.height;
+    for (size_t i = 0; i < runs.lengths.size(); ++i) {
+        if (runs.lengths[i] > cellCount - cell) throw ParseError("Runs cover more than the pattern");
+        for (uint64_t remaining = (i % 2) ? runs.lengths[i] : 0; remaining > 0;) {
+            const uint32_t x = static_cast<uint32_t>(cell % runs.width);
+            const uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(remaining, runs.width - x));
+            pattern.setRun(x, static_cast<uint32_t>(cell / runs.width), count);
+            cell += count;
+            remaining -= count;
+        }
+        if (i % 2 == 0) cell += runs.lengths[i];
+    }
+    return pattern;
+}
+
+Pattern::Runs Pattern::toRuns() const
+{
+    checkRunsFit(width, height);
+    Runs runs;
+    runs.width = width;
+    runs.height = height;
+    runs.rule = rule;
+
+    // Cells where the state flips, found a word at a time
+    uint64_t runStart = 0;
+    bool live = false;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint32_t* words = row(y);
+        for (uint32_t w = 0; w < wordsPerRow; ++w) {
+            const uint32_t validBits = std::min(32u, width - w * 32);
+            const uint32_t valid = validBits == 32 ? 0xFFFFFFFFu : (1u << validBits) - 1u;
+            const uint32_t previous = live ? 1u : 0u;
+            uint32_t flips = (words[w] ^ ((words[w] << 1) | previous)) & valid;
+            live = validBits > 0 && ((words[w] >> (validBits - 1)) & 1u);
+            while (flips) {
+                const uint64_t cell = static_cast<uint64_t>(y) * width + w * 32 + std::countr_zero(flips);
+                runs.lengths.push_back(static_cast<uint32_t>(cell - runStart));
+                runStart = cell;
+                flips &= flips - 1;
+            }
+        }
+    }
+    if (live) runs.lengths.push_back(static_cast<uint32_t>(static_cast<uint64_t>(width) * height - runStart));
+    return runs;
+}
+
+std::string Pattern::writeRle(const Runs& runs)
+{
+    std::string text = "x = " + std::to_string(runs.width) + ", y = " + std::to_string(runs.height);
+    if (runs.rule) text += ", rule = " + runs.rule->toString();
+    text += '\n';
+
+    constexpr size_t MAX_LINE_LENGTH = 70;
+    size_t lineLength = 0;
+    const auto emit = [&](uint64_t count, char tag) {
+        const std::string token = (count > 1 ? std::to_string(count) : std::string()) + tag;
+        if (lineLength + token.size() > MAX_LINE_LENGTH) {
+            text += '\n';
+            lineLength = 0;
+        }
+        text += token;
+        lineLength += token.size();
+    };
+
+    // Live runs are split at row ends, dead cells only show up before live ones
+    uint64_t cell = 0;
+    uint64_t emittedRow = 0;
+    uint64_t emittedX = 0;
+    for (size_t i = 0; i < runs.lengths.size() && runs.width > 0; ++i) {
+        if (i % 2 == 0) {
+            cell += runs.lengths[i];
+            continue;
+        }
+        for (uint64_t remaining = runs.lengths[i]; remaining > 0;) {
+            const uint64_t y = cell / runs.width;
+            const uint64_t x = cell % runs.width;
+            const uint64_t count = std::min<uint64_t>(remaining, runs.width - x);
+            if (y > emittedRow) {
+                emit(y - emittedRow, '$');
+                emittedRow = y;
+                emittedX = 0;
+            }
+            if (x > emittedX) emit(x - emittedX, 'b');
+            emit(count, 'o');
+            emittedX = x + count;
+            cell += count;
+            remaining -= count;
+        }
+    }
+    text += "!\n";
+    return text;
+}
+
+Pattern Pattern::parsePlaintext(std::string_view text, unsigned threadCount)
+{
+    // Lines starting with ! are comments, every other line is a row of . and O
+    struct ChunkInfo {
+        uint64_t rows = 0;
+        size_t width = 0;
+    };
+    const std::vector<std::string_view> chunks = splitChunks(text, '\n', threadCount);
+    std::vector<ChunkInfo> info(chunks.size());
+    runParallel(chunks.size(), threadCount, [&](size_t i) {
+        forEachLine(chunks[i], [&](std::string_view line) {
+            if (!line.empty() && line[0] == '!') return;
+            ++info[i].rows;
+            info[i].width = std::max(info[i].width, line.size());
+        });
+    });
+
+    uint64_t height = 0;
+    size_t width = 0;
+    std::vector<uint64_t> firstRows(chunks.size());
+    for (size_t i = 0; i < chunks.size(); ++i) {
+        firstRows[i] = height;
+        height += info[i].rows;
+        width = std::max(width, info[i].width);
+    }
+    if (width > std::numeric_limits<uint32_t>::max() || height > std::numeric_limits<uint32_t>::max()) {
+        throw ParseError("Plaintext pattern too large");
+    }
+
+    Pattern pattern;
+    pattern.allocate(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    runParallel(chunks.size(), threadCount, [&](size_t i) {
+        uint32_t y = static_cast<uint32_t>(firstRows[i]);
+        forEachLine(chunks[i], [&](std::string_view line) {
+            if (!line.empty() && line[0] == '!') return;
+            uint32_t* words = pattern.row(y++);
+            std::fill(words, words + pattern.wordsPerRow, 0u);
+            for (size_t x = 0; x < line.size(); ++x) {
+                if (isPlaintextCell(line[x])) words[x / 32] |= 1u << (x % 32);
+            }
+        });
+    });
+    return pattern;
+}
+
+Pattern Pattern::parseLife106(std::string_view text, unsigned threadCount)
+{
+    // A #Life 1.06 header and other # lines, then one "x y" line per live cell
+    struct Bounds {
+        int64_t minX = std::numeric_limits<int64_t>::max();
+        int64_t minY = std::numeric_limits<int64_t>::max();
+        int64_t maxX = std::numeric_limits<int64_t>::min();
+        int64_t maxY = std::numeric_limits<int64_t>::min();
+    };
+    const auto forEachCell = [](std::string_view chunk, auto&& cell) {
+        forEachLine(chunk, [&](std::string_view line) {
+            if (trim(line).empty() || line[0] == '#') return;
+            int64_t x, y;
+            if (!parseCoordinates(line, x, y)) throw ParseError("Invalid Life 1.06 line '" + std::string(line) + "'");
+            cell(x, y);
+        });
+    };
+
+    const std::vector<std::string_view> chunks = splitChunks(text, '\n', threadCount);
+    std::vector<Bounds> bounds(chunks.size());
+    runParallel(chunks.size(), threadCount, [&](size_t i) {
+        forEachCell(chunks[i], [&](int64_t x, int64_t y) {
+            bounds[i].minX = std::min(bounds[i].minX, x);
+            bounds[i].minY = std::min(bounds[i].minY, y);
+            bounds[i].maxX = std::max(bounds[i].maxX, x);
+            bounds[i].maxY = std::max(bounds[i].maxY, y);
+        });
+    });
+
+    Bounds total;
+    for (const Bounds& chunk : bounds) {
+        total.minX = std::min(total.minX, chunk.minX);
+        total.minY = std::min(total.minY, chunk.minY);
+        total.maxX = std::max(total.maxX, chunk.maxX);
+        total.maxY = std::max(total.maxY, chunk.maxY);
+    }
+    if (total.maxX < total.minX) return Pattern(0, 0);
+    constexpr uint64_t MAX_EXTENT = std::numeric_limits<uint32_t>::max();
+    if (static_cast<uint64_t>(total.maxX - total.minX) >= MAX_EXTENT || static_cast<uint64_t>(total.maxY - total.minY) >= MAX_EXTENT) {
+        throw ParseError("Life 1.06 pattern too large");
+    }
+
+    Pattern pattern;
+    pattern.allocate(static_cast<uint32_t>(total.maxX - total.minX + 1), static_cast<uint32_t>(total.maxY - total.minY + 1));
+    const uint32_t rowBands = std::max(1u, threadCount);
+    runParallel(rowBands, threadCount, [&](size_t band) {
+        const size_t begin = static_cast<size_t>(pattern.height) * band / rowBands;
+        const size_t end = static_cast<size_t>(pattern.height) * (band + 1) / rowBands;
+        uint32_t* words = pattern.row(static_cast<uint32_t>(begin));
+        std::fill(words, words + (end - begin) * pattern.wordsPerRow, 0u);
+    });
+
+    // Cells come in any order, so chunks may share words
+    runParallel(chunks.size(), threadCount, [&](size_t i) {
+        forEachCell(chunks[i], [&](int64_t x, int64_t y) {
+            const uint32_t column = static_cast<uint32_t>(x - total.minX);
+            uint32_t* word = pattern.row(static_cast<uint32_t>(y - total.minY)) + column / 32;
+            __atomic_fetch_or(word, 1u << (column % 32), __ATOMIC_RELAXED);
+        });
+    });
+    return pattern;
+}
+
+uint64_t Pattern::getPopulation() const
+{
+    uint64_t population = 0;
+    const size_t count = static_cast<size_t>(wordsPerRow) * height;
+    for (size_t i = 0; i < count; ++i) population += std::popcount(words[i]);
+    return population;
+}
+
+void Pattern::setCell(uint32_t x, uint32_t y, bool active)
+{
+    uint32_t& word = row(y)[x / 32];
+    const uint32_t bit = 1u << (x % 32);
+    word = active ? word | bit : word & ~bit;
+}
+
+void Pattern::setRun(uint32_t x, uint32_t y, uint32_t count)
+{
+    uint32_t* words = row(y);
+    const uint64_t end = static_cast<uint64_t>(x) + count;
+    for (uint64_t cell = x; cell < end;) {
+        const uint32_t bit = cell % 32;
+        const uint32_t bits = static_cast<uint32_t>(std::min<uint64_t>(32 - bit, end - cell));
+        words[cell / 32] |= (bits == 32 ? 0xFFFFFFFFu : (1u << bits) - 1u) << bit;
+        cell += bits;
+    }
+}
+
+void Pattern::blitRow(uint32_t y, uint64_t x, uint32_t* target, uint32_t targetWidth) const
+{
+    if (x >= targetWidth) return;
+    const uint32_t* source = row(y);
+    const uint64_t targetWords = (targetWidth + 31) / 32;
+    const uint64_t first = x / 32;
+    const uint32_t shift = x % 32;
+    for (uint64_t w = 0; w < wordsPerRow && first + w < targetWords; ++w) {
+        target[first + w] |= source[w] << shift;
+        if (shift && first + w + 1 < targetWords) target[first + w + 1] |= source[w] >> (32 - shift);
+    }
+    // Cells shifted past the edge of a partial last word
+    if (targetWidth % 32) target[targetWords - 1] &= (1u << (targetWidth % 32)) - 1u;
+}
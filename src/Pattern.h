@@ -0,0 +1,86 @@
+#pragma once
+#include "Simulation.h"
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// A known pattern, decoded from RLE, plaintext (.cells) or Life 1.06 straight into bitpacked rows
+// (32 cells per word along x, bit i of word w holding cell w * 32 + i, like CpuLife and
+// Life::Packing::Bits). Row 0 is the first row of the file, the top of the pattern.
+// Files are memory mapped where possible, and large ones are split on row boundaries and parsed on
+// several threads: one pass counts the rows (or bounds) of every chunk, a second decodes each chunk
+// into the rows it owns.
+class Pattern
+{
+public:
+    enum class Format { Rle, Plaintext, Life106 };
+
+    class ParseError : public std::runtime_error {
+        public:
+            ParseError(const std::string& msg)
+                : std::runtime_error("Pattern parsing failed: " + msg) {}
+    };
+
+    // Run lengths over the cells in row-major order from the top row, alternating dead and live and
+    // starting with a (possibly empty) dead run, cells after the last run are dead. Life uploads
+    // these as they are and decodes them on the GPU, so width * height must fit in 32 bits
+    struct Runs {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        std::optional<Rule> rule;
+        std::vector<uint32_t> lengths;
+    };
+
+    Pattern() = default;
+    // All cells dead
+    Pattern(uint32_t width, uint32_t height);
+
+    // threadCount 0 uses every hardware thread (one without pthreads on the web)
+    static Pattern load(const std::string& path, unsigned threadCount = 0);
+    static Pattern parse(std::string_view text, Format format, unsigned threadCount = 0);
+    // From the extension (.rle, .cells, .lif/.life), or the content when it isn't known
+    static Format detectFormat(const std::string& path, std::string_view text);
+
+    // RLE is converted to runs without expanding a single cell, other formats are parsed first
+    static Runs loadRuns(const std::string& path, unsigned threadCount = 0);
+    static Runs readRuns(std::string_view rleText, unsigned threadCount = 0);
+    static Pattern fromRuns(const Runs& runs);
+    Runs toRuns() const;
+    // RLE text with a header (and the rule, if the runs have one), 70 columns per line
+    static std::string writeRle(const Runs& runs);
+
+    uint32_t getWidth() const { return width; }
+    uint32_t getHeight() const { return height; }
+    uint32_t getWordsPerRow() const { return wordsPerRow; }
+    // The rule from an RLE header, if it had one
+    const std::optional<Rule>& getRule() const { return rule; }
+    uint64_t getPopulation() const;
+
+    const uint32_t* row(uint32_t y) const { return words.get() + static_cast<size_t>(y) * wordsPerRow; }
+    uint32_t* row(uint32_t y) { return words.get() + static_cast<size_t>(y) * wordsPerRow; }
+    bool getCell(uint32_t x, uint32_t y) const { return (row(y)[x / 32] >> (x % 32)) & 1u; }
+    void setCell(uint32_t x, uint32_t y, bool active);
+    // Activates cells [x, x + count) of row y a word at a time
+    void setRun(uint32_t x, uint32_t y, uint32_t count);
+
+    // ORs row y into a bitpacked row of targetWidth cells with its first cell at column x, cells past
+    // targetWidth are clipped
+    void blitRow(uint32_t y, uint64_t x, uint32_t* target, uint32_t targetWidth) const;
+
+private:
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t wordsPerRow = 0;
+    // Left uninitialized by the parsers until the rows are cleared in parallel
+    std::unique_ptr<uint32_t[]> words;
+    std::optional<Rule> rule;
+
+    void allocate(uint32_t width, uint32_t height);
+    static Pattern parseRle(std::string_view text, unsigned threadCount);
+    static Pattern parsePlaintext(std::string_view text, unsigned threadCount);
+    static Pattern parseLife106(std::string_view text, unsigned threadCount);
+};
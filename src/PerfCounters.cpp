@@ -0,0 +1,115 @@
+#include "PerfCounters.h"
+
+#if defined(__linux__)
+#include <cerrno>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace {
+
+struct CounterConfig {
+    uint32_t type;
+    uint64_t config;
+};
+
+// Indexed by PerfCounters::Counter
+constexpr CounterConfig COUNTER_CONFIGS[PerfCounters::COUNTER_COUNT] = {
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16) },
+    { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+};
+
+int openCounter(const CounterConfig& counter)
+{
+    perf_event_attr attr {};
+    attr.size = sizeof(attr);
+    attr.type = counter.type;
+    attr.config = counter.config;
+    attr.disabled = 1;
+    attr.inherit = 1;        // Threads created later count too, which rules out group reads
+    attr.exclude_kernel = 1; // Allowed at perf_event_paranoid 2, the usual default
+    attr.exclude_hv = 1;
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+}
+
+} // namespace
+
+PerfCounters::PerfCounters()
+{
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        descriptors[i] = openCounter(COUNTER_CONFIGS[i]);
+        if (descriptors[i] < 0 && error.empty()) {
+            error = std::string(getName(static_cast<Counter>(i))) + ": " + std::strerror(errno);
+        }
+    }
+}
+
+PerfCounters::~PerfCounters()
+{
+    for (int descriptor : descriptors) if (descriptor >= 0) close(descriptor);
+}
+
+void PerfCounters::start()
+{
+    for (int descriptor : descriptors) {
+        if (descriptor < 0) continue;
+        ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+        ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+PerfCounters::Sample PerfCounters::stop()
+{
+    for (int descriptor : descriptors) if (descriptor >= 0) ioctl(descriptor, PERF_EVENT_IOC_DISABLE, 0);
+
+    Sample sample;
+    for (int i = 0; i < COUNTER_COUNT; ++i) {
+        if (descriptors[i] < 0) continue;
+        uint64_t values[3] {}; // Count, time enabled, time running
+        if (read(descriptors[i], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)) || values[2] == 0) continue;
+        sample.values[i] = static_cast<double>(values[0]) * values[1] / values[2];
+        sample.valid[i] = true;
+    }
+    return sample;
+}
+
+#else
+
+PerfCounters::PerfCounters()
+    : error("Performance counters need Linux (perf_event_open)")
+{
+    descriptors.fill(-1);
+}
+
+PerfCounters::~PerfCounters()
+{
+}
+
+void PerfCounters::start()
+{
+}
+
+PerfCounters::Sample PerfCounters::stop()
+{
+    return {};
+}
+
+#endif
+
+bool PerfCounters::isAvailable() const
+{
+    for (int descriptor : descriptors) if (descriptor >= 0) return true;
+    return false;
+}
+
+const char* PerfCounters::getName(Counter counter)
+{
+    static constexpr const char* NAMES[COUNTER_COUNT] = { "cycles", "instructions", "l1d_misses", "llc_misses", "branch_misses" };
+    return NAMES[counter];
+}
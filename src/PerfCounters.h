@@ -0,0 +1,44 @@
+#pragma once
+#include <array>
+#include <cstdint>
+#include <string>
+
+// Hardware counters of this process around a measured region, through perf_event_open (Linux only).
+// Counters are inherited by threads created after construction, so open them before the engine that
+// spawns its workers (CpuLife's pool, the GPU driver's threads) and they count the whole run.
+// Counters the CPU or kernel refuse (perf_event_paranoid, containers, VMs) are left out, the others
+// still count. Multiplexed counters are scaled up to the time the region ran
+class PerfCounters
+{
+public:
+    enum Counter { Cycles, Instructions, L1DMisses, LlcMisses, BranchMisses, COUNTER_COUNT };
+
+    struct Sample {
+        std::array<double, COUNTER_COUNT> values {};
+        std::array<bool, COUNTER_COUNT> valid {};
+
+        bool has(Counter counter) const { return valid[counter]; }
+        bool any() const { for (bool counted : valid) if (counted) return true; return false; }
+        double get(Counter counter) const { return values[counter]; }
+        double ipc() const { return has(Cycles) && has(Instructions) && get(Cycles) > 0 ? get(Instructions) / get(Cycles) : 0.0; }
+    };
+
+    PerfCounters();
+    ~PerfCounters();
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    // Whether at least one counter opened, getError() says why the first missing one didn't
+    bool isAvailable() const;
+    const std::string& getError() const { return error; }
+
+    // Resets and enables every counter, stop() disables them and reads the counts since start()
+    void start();
+    Sample stop();
+
+    static const char* getName(Counter counter);
+
+private:
+    std::array<int, COUNTER_COUNT> descriptors;
+    std::string error;
+};
@@ -0,0 +1,183 @@
+#include "PipelineCache.h"
+
+PipelineCache::KeyBuilder& PipelineCache::KeyBuilder::add(const std::string& text)
+{
+    add(static_cast<uint64_t>(text.size()));
+    addBytes(text.data(), text.size());
+    return *this;
+}
+
+PipelineCache::KeyBuilder& PipelineCache::KeyBuilder::add(uint64_t value)
+{
+    addBytes(&value, sizeof(value));
+    return *this;
+}
+
+void PipelineCache::KeyBuilder::addBytes(const void* data, size_t size)
+{
+    constexpr uint64_t FNV_PRIME = 1099511628211ull;
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ bytes[i]) * FNV_PRIME;
+    }
+}
+
+PipelineCache::PipelineCache(wgpu::Device device)
+    : device(device)
+{
+}
+
+PipelineCache::~PipelineCache()
+{
+    for (auto& [key, pipeline] : computePipelines) pipeline.release();
+    for (auto& [key, pipeline] : renderPipelines) pipeline.release();
+    for (auto& [key, layout] : pipelineLayouts) layout.release();
+    for (auto& [key, layout] : bindGroupLayouts) layout.release();
+    for (auto& [key, module] : shaderModules) module.release();
+}
+
+wgpu::ShaderModule PipelineCache::shaderModule(const std::string& name, const Shader::Defines& defines,
+                                               Key& sourceKey)
+{
+    // Different defines often produce the same source (e.g. ones a shader never tests)
+    const std::string source = Shader::preprocess(name, defines);
+    sourceKey = KeyBuilder().add(source).get();
+
+    const auto cached = shaderModules.find(sourceKey);
+    if (cached != shaderModules.end()) {
+        ++hits;
+        return cached->second;
+    }
+    ++misses;
+    wgpu::ShaderModule module = Shader::createFromCode(device, source);
+    if (module) shaderModules.emplace(sourceKey, module);
+    return module;
+}
+
+wgpu::BindGroupLayout PipelineCache::bindGroupLayout(const wgpu::BindGroupLayoutDescriptor& descriptor)
+{
+    KeyBuilder builder;
+    builder.add(descriptor.entryCount);
+    for (size_t i = 0; i < descriptor.entryCount; ++i) {
+        const WGPUBindGroupLayoutEntry& entry = descriptor.entries[i];
+        builder.add(entry.binding).add(entry.visibility)
+               .add(entry.buffer.type).add(entry.buffer.hasDynamicOffset).add(entry.buffer.minBindingSize)
+               .add(entry.sampler.type)
+               .add(entry.texture.sampleType).add(entry.texture.viewDimension).add(entry.texture.multisampled)
+               .add(entry.storageTexture.access).add(entry.storageTexture.format)
+               .add(entry.storageTexture.viewDimension);
+    }
+    const Key key = builder.get();
+
+    const auto cached = bindGroupLayouts.find(key);
+    if (cached != bindGroupLayouts.end()) {
+        ++hits;
+        return cached->second;
+    }
+    ++misses;
+    wgpu::BindGroupLayout layout = device.createBindGroupLayout(descriptor);
+    if (layout) bindGroupLayouts.emplace(key, layout);
+    return layout;
+}
+
+wgpu::PipelineLayout PipelineCache::pipelineLayout(const wgpu::BindGroupLayout& bindGroupLayout)
+{
+    // Bind group layouts are deduplicated above, so the handle identifies the layout
+    const Key key = KeyBuilder().add(reinterpret_cast<uintptr_t>(static_cast<WGPUBindGroupLayout>(bindGroupLayout))).get();
+
+    const auto cached = pipelineLayouts.find(key);
+    if (cached != pipelineLayouts.end()) {
+        ++hits;
+        return cached->second;
+    }
+    ++misses;
+    wgpu::PipelineLayoutDescriptor layoutDesc {};
+    layoutDesc.setDefault();
+    layoutDesc.bindGroupLayoutCount = 1;
+    layoutDesc.bindGroupLayouts = reinterpret_cast<const WGPUBindGroupLayout*>(&bindGroupLayout);
+    wgpu::PipelineLayout layout = device.createPipelineLayout(layoutDesc);
+    if (layout) pipelineLayouts.emplace(key, layout);
+    return layout;
+}
+
+void PipelineCache::renderPipeline(Key key, const wgpu::RenderPipelineDescriptor& descriptor,
+                                   RenderPipelineReady&& ready)
+{
+    if (!notifying) finishedRenderRequests.clear();
+    const auto cached = renderPipelines.find(key);
+    if (cached != renderPipelines.end()) {
+        ++hits;
+        ready(cached->second, nullptr);
+        return;
+    }
+
+    auto pending = pendingRenderPipelines.find(key);
+    if (pending != pendingRenderPipelines.end()) {
+        pending->second.waiters.push_back(std::move(ready));
+        return;
+    }
+
+    ++misses;
+    pendingRenderPipelines[key].waiters.push_back(std::move(ready));
+    auto request = device.createRenderPipelineAsync(descriptor,
+        [this, key](wgpu::CreatePipelineAsyncStatus status, wgpu::RenderPipeline pipeline, const char* message) {
+            auto finished = pendingRenderPipelines.find(key);
+            auto waiters = std::move(finished->second.waiters);
+            finishedRenderRequests.push_back(std::move(finished->second.request));
+            pendingRenderPipelines.erase(finished);
+
+            const bool success = status == wgpu::CreatePipelineAsyncStatus::Success && pipeline;
+            if (success) renderPipelines.emplace(key, pipeline);
+            notifying = true;
+            for (auto& waiter : waiters) {
+                waiter(success ? pipeline : wgpu::RenderPipeline{nullptr}, success ? nullptr : message);
+            }
+            notifying = false;
+        });
+
+    // Implementations may complete the request before returning
+    pending = pendingRenderPipelines.find(key);
+    if (pending != pendingRenderPipelines.end()) pending->second.request = std::move(request);
+    else finishedRenderRequests.push_back(std::move(request));
+}
+
+void PipelineCache::computePipeline(Key key, const wgpu::ComputePipelineDescriptor& descriptor,
+                                    ComputePipelineReady&& ready)
+{
+    if (!notifying) finishedComputeRequests.clear();
+    const auto cached = computePipelines.find(key);
+    if (cached != computePipelines.end()) {
+        ++hits;
+        ready(cached->second, nullptr);
+        return;
+    }
+
+    auto pending = pendingComputePipelines.find(key);
+    if (pending != pendingComputePipelines.end()) {
+        pending->second.waiters.push_back(std::move(ready));
+        return;
+    }
+
+    ++misses;
+    pendingComputePipelines[key].waiters.push_back(std::move(ready));
+    auto request = device.createComputePipelineAsync(descriptor,
+        [this, key](wgpu::CreatePipelineAsyncStatus status, wgpu::ComputePipeline pipeline, const char* message) {
+            auto finished = pendingComputePipelines.find(key);
+            auto waiters = std::move(finished->second.waiters);
+            finishedComputeRequests.push_back(std::move(finished->second.request));
+            pendingComputePipelines.erase(finished);
+
+            const bool success = status == wgpu::CreatePipelineAsyncStatus::Success && pipeline;
+            if (success) computePipelines.emplace(key, pipeline);
+            notifying = true;
+            for (auto& waiter : waiters) {
+                waiter(success ? pipeline : wgpu::ComputePipeline{nullptr}, success ? nullptr : message);
+            }
+            notifying = false;
+        });
+
+    // Implementations may complete the request before returning
+    pending = pendingComputePipelines.find(key);
+    if (pending != pendingComputePipelines.end()) pending->second.request = std::move(request);
+    else finishedComputeRequests.push_back(std::move(request));
+}
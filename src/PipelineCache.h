@@ -0,0 +1,80 @@
+#pragma once
+
+#include "webgpu.hpp"
+#include "Shader.h"
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Shader modules, bind group layouts and pipelines of one device, keyed by a hash of everything
+// that goes into them (preprocessed source, entry point, target format, layout).
+// Requesting a variant that was compiled before returns the existing object without touching the
+// shader compiler, so switching between configurations costs a map lookup.
+// The cache owns every object it hands out, they stay valid until the cache is destroyed.
+class PipelineCache
+{
+public:
+    using Key = uint64_t;
+
+    // FNV-1a over the parts of a key, fed in a fixed order
+    class KeyBuilder {
+        public:
+            KeyBuilder& add(const std::string& text);
+            KeyBuilder& add(uint64_t value);
+            Key get() const { return hash; }
+        private:
+            uint64_t hash = 14695981039346656037ull;
+            void addBytes(const void* data, size_t size);
+    };
+
+    // Called once the pipeline exists, pipeline is null and message is set on failure
+    using RenderPipelineReady = std::function<void(wgpu::RenderPipeline pipeline, const char* message)>;
+    using ComputePipelineReady = std::function<void(wgpu::ComputePipeline pipeline, const char* message)>;
+
+    explicit PipelineCache(wgpu::Device device);
+    ~PipelineCache();
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+    // Preprocesses the shader and compiles it, unless an identical source was compiled before.
+    // sourceKey identifies the preprocessed source, pipeline keys should include it
+    wgpu::ShaderModule shaderModule(const std::string& name, const Shader::Defines& defines, Key& sourceKey);
+    wgpu::BindGroupLayout bindGroupLayout(const wgpu::BindGroupLayoutDescriptor& descriptor);
+    wgpu::PipelineLayout pipelineLayout(const wgpu::BindGroupLayout& bindGroupLayout);
+
+    // Hits call ready before returning, misses compile in the background and call ready from the
+    // event loop. Concurrent requests for one key share a single compilation
+    void renderPipeline(Key key, const wgpu::RenderPipelineDescriptor& descriptor, RenderPipelineReady&& ready);
+    void computePipeline(Key key, const wgpu::ComputePipelineDescriptor& descriptor, ComputePipelineReady&& ready);
+
+    uint64_t getHits() const { return hits; }
+    uint64_t getMisses() const { return misses; }
+
+private:
+    // The request handle must outlive its callback, so finished requests are only dropped by a later
+    // request made outside of any callback
+    template <typename Pipeline, typename Callback>
+    struct PendingPipeline {
+        std::unique_ptr<Callback> request;
+        std::vector<std::function<void(Pipeline, const char*)>> waiters;
+    };
+    using PendingRenderPipeline = PendingPipeline<wgpu::RenderPipeline, wgpu::CreateRenderPipelineAsyncCallback>;
+    using PendingComputePipeline = PendingPipeline<wgpu::ComputePipeline, wgpu::CreateComputePipelineAsyncCallback>;
+
+    wgpu::Device device;
+    std::unordered_map<Key, wgpu::ShaderModule> shaderModules;
+    std::unordered_map<Key, wgpu::BindGroupLayout> bindGroupLayouts;
+    std::unordered_map<Key, wgpu::PipelineLayout> pipelineLayouts;
+    std::unordered_map<Key, wgpu::RenderPipeline> renderPipelines;
+    std::unordered_map<Key, wgpu::ComputePipeline> computePipelines;
+    std::unordered_map<Key, PendingRenderPipeline> pendingRenderPipelines;
+    std::unordered_map<Key, PendingComputePipeline> pendingComputePipelines;
+    std::vector<std::unique_ptr<wgpu::CreateRenderPipelineAsyncCallback>> finishedRenderRequests;
+    std::vector<std::unique_ptr<wgpu::CreateComputePipelineAsyncCallback>> finishedComputeRequests;
+    bool notifying = false;
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+};
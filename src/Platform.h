@@ -0,0 +1,29 @@
+#pragma once
+
+#include "webgpu.hpp"
+#include <cstdint>
+#include <functional>
+
+// Host environment specifics, implemented once per target:
+// PlatformWeb.cpp (Emscripten, #canvas surface, browser main loop) and
+// PlatformNative.cpp (native WebGPU implementation, headless, plain loop)
+class Platform {
+public:
+    // Whether createSurface can present to a window, native builds only render headless
+    static bool hasSurface();
+    static wgpu::Surface createSurface(const wgpu::Instance& instance);
+    static void getSurfaceSize(int& width, int& height);
+
+    // Draws an RGBA image over the whole canvas through a 2D context for the CPU engine (CpuLife),
+    // natively it does nothing. index.html picks the engine before either one starts
+    static void presentPixels(const uint8_t* rgba, uint32_t width, uint32_t height);
+
+    // Calls frame until it returns false. The browser keeps calling it once per animation frame
+    // and never returns to the caller, so anything after runLoop only runs natively
+    static void runLoop(const std::function<bool()>& frame);
+
+    // Delivers pending WebGPU callbacks without blocking. The browser delivers them from its own
+    // event loop, so there it does nothing and waiting on a callback is impossible (canBlock)
+    static void processEvents(const wgpu::Instance& instance);
+    static bool canBlock();
+};
@@ -0,0 +1,37 @@
+#include "Platform.h"
+#include <stdexcept>
+
+bool Platform::hasSurface()
+{
+    return false;
+}
+
+wgpu::Surface Platform::createSurface(const wgpu::Instance&)
+{
+    throw std::runtime_error("Native builds have no window surface, run headless instead");
+}
+
+void Platform::getSurfaceSize(int& width, int& height)
+{
+    width = 0;
+    height = 0;
+}
+
+void Platform::presentPixels(const uint8_t*, uint32_t, uint32_t)
+{
+}
+
+void Platform::runLoop(const std::function<bool()>& frame)
+{
+    while (frame()) {}
+}
+
+void Platform::processEvents(const wgpu::Instance& instance)
+{
+    instance.processEvents();
+}
+
+bool Platform::canBlock()
+{
+    return true;
+}
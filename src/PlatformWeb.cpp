@@ -0,0 +1,76 @@
+#include "Platform.h"
+#include <emscripten/em_js.h>
+#include <emscripten/html5.h>
+#include <stdexcept>
+
+static constexpr const char* CANVAS_SELECTOR = "#canvas";
+static constexpr int FPS = 0;
+static constexpr bool SIMULATE_INFINITE_LOOP = true;
+
+bool Platform::hasSurface()
+{
+    return true;
+}
+
+wgpu::Surface Platform::createSurface(const wgpu::Instance& instance)
+{
+    wgpu::SurfaceDescriptorFromCanvasHTMLSelector surfaceSelector {};
+    surfaceSelector.setDefault();
+    surfaceSelector.selector = CANVAS_SELECTOR;
+
+    wgpu::SurfaceDescriptor surfaceDesc {};
+    surfaceDesc.setDefault();
+    surfaceDesc.nextInChain = reinterpret_cast<WGPUChainedStruct*>(&surfaceSelector);
+    return instance.createSurface(surfaceDesc);
+}
+
+void Platform::getSurfaceSize(int& width, int& height)
+{
+    emscripten_get_canvas_element_size(CANVAS_SELECTOR, &width, &height);
+}
+
+// The image goes through a grid sized canvas, then gets scaled onto the page canvas like the WebGPU
+// draw stretches the grid over clip space. With threads the heap is shared memory, which ImageData
+// doesn't accept, so the pixels are copied out first
+EM_JS(void, presentPixelsJs, (const uint8_t* rgba, uint32_t width, uint32_t height), {
+    const canvas = Module.canvas;
+    let frame = Module.lifeFrameCanvas;
+    if (!frame || frame.width != width || frame.height != height) {
+        frame = Module.lifeFrameCanvas = new OffscreenCanvas(width, height);
+    }
+    const pixels = new Uint8ClampedArray(HEAPU8.slice(rgba, rgba + width * height * 4).buffer);
+    frame.getContext('2d').putImageData(new ImageData(pixels, width, height), 0, 0);
+
+    const context = canvas.getContext('2d');
+    context.imageSmoothingEnabled = false;
+    context.drawImage(frame, 0, 0, canvas.width, canvas.height);
+});
+
+void Platform::presentPixels(const uint8_t* rgba, uint32_t width, uint32_t height)
+{
+    presentPixelsJs(rgba, width, height);
+}
+
+void Platform::runLoop(const std::function<bool()>& frame)
+{
+    // SIMULATE_INFINITE_LOOP never returns to the caller, so frame stays alive on its stack
+    emscripten_set_main_loop_arg(
+        [](void* arg) {
+            auto* loop = static_cast<const std::function<bool()>*>(arg);
+            if (!(*loop)()) emscripten_cancel_main_loop();
+        },
+        const_cast<std::function<bool()>*>(&frame),
+        FPS,
+        SIMULATE_INFINITE_LOOP
+    );
+}
+
+void Platform::processEvents(const wgpu::Instance&)
+{
+}
+
+bool Platform::canBlock()
+{
+    // Callbacks only run once control returns to the browser
+    return false;
+}
@@ -0,0 +1,88 @@
+#include "Random.h"
+#include "Simd.h"
+#include <algorithm>
+#include <bit>
+
+namespace {
+
+// lowbias32, the same hash as random.wgsl. Word is uint32_t or WordVector
+template <typename Word>
+Word hash32(Word x)
+{
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// randomWord(key, hash32(group), row, level) is hash32(hash32(group) ^ salt[level]), so the part that
+// does not depend on the group is hashed once per row (rowSalt in random.wgsl)
+struct RowSalts {
+    uint32_t first;
+    uint32_t salt[8];
+
+    RowSalts(uint64_t seed, uint32_t row, uint32_t threshold)
+        : first(static_cast<uint32_t>(std::countr_zero(threshold)))
+    {
+        const uint64_t key = Random::key(seed);
+        const uint32_t keyLow = static_cast<uint32_t>(key);
+        const uint32_t keyHigh = static_cast<uint32_t>(key >> 32);
+        for (uint32_t level = first; level < 8; ++level) {
+            salt[level] = hash32(keyHigh ^ hash32(keyLow ^ hash32(row ^ hash32(level))));
+        }
+    }
+};
+
+// Walks the binary expansion of the density like randomCells in random.wgsl
+template <typename Word>
+Word cellWords(const RowSalts& salts, Word group, uint32_t threshold)
+{
+    Word result = group ^ group;
+    const Word mixedGroup = hash32<Word>(group);
+    for (uint32_t level = salts.first; level < 8; ++level) {
+        const Word word = hash32<Word>(mixedGroup ^ salts.salt[level]);
+        result = (threshold >> level) & 1u ? result | word : result & word;
+    }
+    return result;
+}
+
+} // namespace
+
+uint32_t Random::densityThreshold(float density)
+{
+    return static_cast<uint32_t>(std::clamp(density, 0.0f, 1.0f) * 256.0f + 0.5f);
+}
+
+uint64_t Random::key(uint64_t seed)
+{
+    seed = (seed ^ (seed >> 30)) * 0xbf58476d1ce4e5b9ull;
+    seed = (seed ^ (seed >> 27)) * 0x94d049bb133111ebull;
+    return seed ^ (seed >> 31);
+}
+
+uint32_t Random::cells(uint64_t seed, uint32_t group, uint32_t row, uint32_t threshold)
+{
+    if (threshold >= 256) return 0xFFFFFFFFu;
+    if (threshold == 0) return 0;
+    return cellWords<uint32_t>(RowSalts(seed, row, threshold), group, threshold);
+}
+
+void Random::fillCells(uint64_t seed, uint32_t row, uint32_t firstGroup, uint32_t count, uint32_t threshold, uint32_t* words)
+{
+    if (threshold == 0 || threshold >= 256) {
+        std::fill(words, words + count, threshold == 0 ? 0u : 0xFFFFFFFFu);
+        return;
+    }
+
+    const RowSalts salts(seed, row, threshold);
+    WordVector groups;
+    for (uint32_t lane = 0; lane < VECTOR_WORDS; ++lane) groups[lane] = firstGroup + lane;
+
+    uint32_t i = 0;
+    for (; i + VECTOR_WORDS <= count; i += VECTOR_WORDS, groups += VECTOR_WORDS) {
+        storeWords(words + i, cellWords<WordVector>(salts, groups, threshold));
+    }
+    for (; i < count; ++i) words[i] = cellWords<uint32_t>(salts, firstGroup + i, threshold);
+}
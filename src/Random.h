@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// Counter-based random cells, the host side of shaders/random.wgsl. Every group of 32 cells is a
+// pure function of (seed, group, row, density), so rows can be filled in any order on any number of
+// threads, and a soup seeded here is bit for bit the one the GPU seeding pass produces
+class Random {
+public:
+    // Density in 1/256 steps as passed to the seeding pass, 256 makes every cell active
+    static uint32_t densityThreshold(float density);
+
+    // Key the cells are derived from, passed to the seeding pass in place of the seed since WGSL has
+    // no 64-bit integers. splitmix64's finalizer, a bijection, so distinct seeds never share a key
+    static uint64_t key(uint64_t seed);
+
+    // 32 cells of a row, bit i is cell group * 32 + i
+    static uint32_t cells(uint64_t seed, uint32_t group, uint32_t row, uint32_t threshold);
+
+    // Groups [firstGroup, firstGroup + count) of a row into words[0, count), four groups per vector op
+    static void fillCells(uint64_t seed, uint32_t row, uint32_t firstGroup, uint32_t count, uint32_t threshold, uint32_t* words);
+};
@@ -0,0 +1,251 @@
+#include "Recorder.h"
+#include "ZeroRuns.h"
+#include <algorithm>
+#include <cstring>
+
+Recorder::Recorder(const std::string& path, const Config& config)
+    : config(config)
+    , gridWords(static_cast<size_t>((config.width + 31) / 32) * config.height)
+    , nextGeneration(config.firstGeneration)
+{
+    if (gridWords == 0) throw RecordError("Empty grid");
+    if (config.keyframeInterval == 0) throw RecordError("Keyframe interval must be positive");
+
+    stream.open(path, std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) throw RecordError("Failed to open " + path);
+    FileHeader header {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.width = config.width;
+    header.height = config.height;
+    header.birth = config.rule.birth;
+    header.survival = config.rule.survival;
+    header.boundary = static_cast<uint32_t>(config.boundary);
+    header.keyframeInterval = config.keyframeInterval;
+    header.firstGeneration = config.firstGeneration;
+    stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    writeOffset = sizeof(header);
+
+    this->config.maxQueuedFrames = std::max<size_t>(1, config.maxQueuedFrames);
+    writer = std::thread(&Recorder::writerLoop, this);
+}
+
+Recorder::~Recorder()
+{
+    try {
+        finish();
+    } catch (...) {
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    if (writer.joinable()) writer.join();
+}
+
+void Recorder::submit(uint64_t generation, std::vector<uint32_t>&& grid)
+{
+    if (grid.size() != gridWords) throw RecordError("Grid of generation " + std::to_string(generation) + " has the wrong size");
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (error) std::rethrow_exception(error);
+        if (finished) throw RecordError("Submitting after finish");
+        if (generation != nextGeneration) {
+            throw RecordError("Expected generation " + std::to_string(nextGeneration) + ", got " + std::to_string(generation));
+        }
+        spaceAvailable.wait(lock, [this] { return pending.size() < config.maxQueuedFrames; });
+        pending.push(std::move(grid));
+        ++nextGeneration;
+    }
+    workAvailable.notify_one();
+}
+
+void Recorder::finish()
+{
+    std::unique_lock<std::mutex> lock(mutex);
+    idle.wait(lock, [this] { return pending.empty() && !writing; });
+    if (error) std::rethrow_exception(error);
+    if (finished) return;
+    finished = true;
+    writeIndex();
+}
+
+uint64_t Recorder::getFramesWritten() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return framesWritten;
+}
+
+void Recorder::writerLoop()
+{
+    while (true) {
+        std::vector<uint32_t> grid;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            workAvailable.wait(lock, [this] { return stopping || !pending.empty(); });
+            if (pending.empty()) return;
+            grid = std::move(pending.front());
+            pending.pop();
+            writing = true;
+        }
+        spaceAvailable.notify_one();
+
+        bool failed = false;
+        try {
+            writeFrame(std::move(grid));
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!error) error = std::current_exception();
+            failed = true;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            writing = false;
+            if (!failed) ++framesWritten;
+            // Later deltas would be against a frame that was never written, so drop them
+            if (error) pending = {};
+            if (pending.empty()) idle.notify_all();
+        }
+        spaceAvailable.notify_all();
+    }
+}
+
+void Recorder::writeFrame(std::vector<uint32_t>&& grid)
+{
+    FrameHeader frame {};
+    const uint32_t* words = grid.data();
+    if (frameOffsets.size() % config.keyframeInterval == 0) {
+        frame.flags = KEYFRAME;
+    } else {
+        delta.resize(gridWords);
+        for (size_t i = 0; i < gridWords; ++i) delta[i] = grid[i] ^ previous[i];
+        words = delta.data();
+    }
+    size_t wordCount = gridWords;
+    ZeroRuns::compress(words, gridWords, compressed);
+    if (compressed.size() < gridWords) {
+        frame.flags |= COMPRESSED;
+        words = compressed.data();
+        wordCount = compressed.size();
+    }
+    frame.wordCount = static_cast<uint32_t>(wordCount);
+
+    stream.write(reinterpret_cast<const char*>(&frame), sizeof(frame));
+    stream.write(reinterpret_cast<const char*>(words), static_cast<std::streamsize>(wordCount * sizeof(uint32_t)));
+    if (!stream) throw RecordError("Failed to write frame " + std::to_string(frameOffsets.size()));
+    frameOffsets.push_back(writeOffset);
+    writeOffset += sizeof(frame) + wordCount * sizeof(uint32_t);
+    previous = std::move(grid);
+}
+
+void Recorder::writeIndex()
+{
+    IndexFooter footer {};
+    footer.indexOffset = writeOffset;
+    footer.frameCount = frameOffsets.size();
+    std::memcpy(footer.magic, INDEX_MAGIC, sizeof(INDEX_MAGIC));
+    stream.write(reinterpret_cast<const char*>(frameOffsets.data()), static_cast<std::streamsize>(frameOffsets.size() * sizeof(uint64_t)));
+    stream.write(reinterpret_cast<const char*>(&footer), sizeof(footer));
+    stream.close();
+    if (!stream) throw RecordError("Failed to write the frame index");
+}
+
+Recording::Recording(const std::string& path)
+    // Seeks only touch the frames they decode
+    : file(std::make_unique<MappedFile>(path, false))
+{
+    if (file->size() < sizeof(header)) throw Recorder::RecordError(path + " is too short for a recording");
+    std::memcpy(&header, file->data(), sizeof(header));
+    if (std::memcmp(header.magic, Recorder::MAGIC, sizeof(Recorder::MAGIC)) != 0) throw Recorder::RecordError(path + " is not a recording");
+    if (header.version != Recorder::VERSION) {
+        throw Recorder::RecordError(path + " has version " + std::to_string(header.version)
+            + ", expected " + std::to_string(Recorder::VERSION));
+    }
+    if (header.width == 0 || header.height == 0 || header.keyframeInterval == 0
+        || header.boundary > static_cast<uint32_t>(Boundary::Dead)) {
+        throw Recorder::RecordError(path + " has a malformed header");
+    }
+    gridWords = static_cast<size_t>(getWordsPerRow()) * header.height;
+    indexFrames();
+}
+
+bool Recording::readFrameAt(uint64_t offset, Recorder::FrameHeader& frame) const
+{
+    if (offset + sizeof(frame) > file->size()) return false;
+    std::memcpy(&frame, file->data() + offset, sizeof(frame));
+    return offset + sizeof(frame) + static_cast<uint64_t>(frame.wordCount) * sizeof(uint32_t) <= file->size();
+}
+
+void Recording::indexFrames()
+{
+    Recorder::IndexFooter footer {};
+    if (file->size() >= sizeof(header) + sizeof(footer)) {
+        std::memcpy(&footer, file->data() + file->size() - sizeof(footer), sizeof(footer));
+        const bool indexed = std::memcmp(footer.magic, Recorder::INDEX_MAGIC, sizeof(Recorder::INDEX_MAGIC)) == 0
+            && footer.indexOffset <= file->size() - sizeof(footer)
+            && footer.frameCount == (file->size() - sizeof(footer) - footer.indexOffset) / sizeof(uint64_t);
+        if (indexed) {
+            frameOffsets.resize(footer.frameCount);
+            std::memcpy(frameOffsets.data(), file->data() + footer.indexOffset, frameOffsets.size() * sizeof(uint64_t));
+            return;
+        }
+    }
+
+    // No index, the recorder never finished. Walk the frames up to the first incomplete one
+    uint64_t offset = sizeof(header);
+    Recorder::FrameHeader frame {};
+    while (readFrameAt(offset, frame)) {
+        frameOffsets.push_back(offset);
+        offset += sizeof(frame) + static_cast<uint64_t>(frame.wordCount) * sizeof(uint32_t);
+    }
+}
+
+const std::vector<uint32_t>& Recording::seek(uint64_t generation)
+{
+    if (generation < header.firstGeneration || generation - header.firstGeneration >= frameOffsets.size()) {
+        throw Recorder::RecordError("Generation " + std::to_string(generation) + " is not in the recording");
+    }
+    const uint64_t target = generation - header.firstGeneration;
+    const uint64_t keyframe = target - target % header.keyframeInterval;
+    if (gridFrame == UINT64_MAX || gridFrame < keyframe || gridFrame > target) {
+        gridFrame = UINT64_MAX;
+        grid.resize(gridWords);
+        applyFrame(keyframe);
+        gridFrame = keyframe;
+    }
+    while (gridFrame < target) {
+        applyFrame(gridFrame + 1);
+        ++gridFrame;
+    }
+    return grid;
+}
+
+void Recording::applyFrame(uint64_t index)
+{
+    Recorder::FrameHeader frame {};
+    if (!readFrameAt(frameOffsets[index], frame)) throw Recorder::RecordError("Frame " + std::to_string(index) + " is truncated");
+    const auto* words = reinterpret_cast<const uint32_t*>(file->data() + frameOffsets[index] + sizeof(frame));
+    const bool keyframe = (frame.flags & Recorder::KEYFRAME) != 0;
+    if (keyframe != (index % header.keyframeInterval == 0)) {
+        throw Recorder::RecordError("Frame " + std::to_string(index) + " is out of place");
+    }
+
+    bool valid = true;
+    if (frame.flags & Recorder::COMPRESSED) {
+        valid = keyframe ? ZeroRuns::expand(words, frame.wordCount, grid.data(), gridWords)
+                         : ZeroRuns::applyXor(words, frame.wordCount, grid.data(), gridWords);
+    } else if (frame.wordCount != gridWords) {
+        valid = false;
+    } else if (keyframe) {
+        std::copy(words, words + gridWords, grid.data());
+    } else {
+        for (size_t i = 0; i < gridWords; ++i) grid[i] ^= words[i];
+    }
+    if (!valid) {
+        // grid is half updated, the next seek starts over from a keyframe
+        gridFrame = UINT64_MAX;
+        throw Recorder::RecordError("Frame " + std::to_string(index) + " is corrupt");
+    }
+}
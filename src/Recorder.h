@@ -0,0 +1,146 @@
+#pragma once
+#include "MappedFile.h"
+#include "Simulation.h"
+#include <condition_variable>
+#include <cstdint>
+#include <exception>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Records consecutive generations of a bitpacked grid (32 cells per word, grid row order like
+// Checkpoint) into one file: every keyframeInterval-th generation in full, the others as the XOR with
+// the generation before, both squeezed with ZeroRuns. Deltas between generations are mostly empty
+// words, so a million-generation run costs little more than its activity. Deltas are computed,
+// compressed and written on a background thread, and a frame index is appended on finish().
+// Recording reads the file back: the index makes finding any generation's keyframe O(1), from where
+// at most keyframeInterval - 1 deltas rebuild it.
+class Recorder
+{
+public:
+    struct Config {
+        uint32_t width = 0;
+        uint32_t height = 0;
+        Rule rule {};
+        Boundary boundary = Boundary::Torus;
+        uint64_t firstGeneration = 0;   // Generation of the first submitted grid
+        uint32_t keyframeInterval = 256;
+        size_t maxQueuedFrames = 4;     // Grids waiting for the writer, submit blocks beyond that
+    };
+
+    class RecordError : public std::runtime_error {
+        public:
+            RecordError(const std::string& msg)
+                : std::runtime_error("Recording failed: " + msg) {}
+    };
+
+    Recorder(const std::string& path, const Config& config);
+    // Finishes the file if finish() wasn't called, errors are lost then
+    ~Recorder();
+    Recorder(const Recorder&) = delete;
+    Recorder& operator=(const Recorder&) = delete;
+
+    // Queues the grid of generation (height rows of (width + 31) / 32 words), generations must follow
+    // each other. Rethrows the first writer error
+    void submit(uint64_t generation, std::vector<uint32_t>&& grid);
+    // Waits for every queued grid, then writes the index. Rethrows the first writer error
+    void finish();
+    uint64_t getFramesWritten() const;
+
+private:
+    friend class Recording;
+
+    // On-disk layout: FileHeader, frames (FrameHeader and its words), index (one frame offset per
+    // frame) and IndexFooter. A file without a footer (the recorder died) is indexed by walking the frames
+    static constexpr char MAGIC[8] = { 'L', 'I', 'F', 'E', 'R', 'E', 'C', '\0' };
+    static constexpr char INDEX_MAGIC[8] = { 'L', 'I', 'F', 'E', 'I', 'D', 'X', '\0' };
+    static constexpr uint32_t VERSION = 1;
+    struct FileHeader {
+        char magic[8];
+        uint32_t version;
+        uint32_t width;
+        uint32_t height;
+        uint16_t birth;
+        uint16_t survival;
+        uint32_t boundary;
+        uint32_t keyframeInterval;
+        uint64_t firstGeneration;
+    };
+    static_assert(sizeof(FileHeader) == 40, "FileHeader is written as it is");
+    enum FrameFlags : uint32_t { KEYFRAME = 1, COMPRESSED = 2 };
+    struct FrameHeader {
+        uint32_t wordCount; // Stored words that follow
+        uint32_t flags;
+    };
+    static_assert(sizeof(FrameHeader) == 8, "FrameHeader is written as it is");
+    struct IndexFooter {
+        uint64_t indexOffset;
+        uint64_t frameCount;
+        char magic[8];
+    };
+    static_assert(sizeof(IndexFooter) == 24, "IndexFooter is written as it is");
+
+    Config config;
+    size_t gridWords;
+    std::ofstream stream;
+    std::vector<uint64_t> frameOffsets; // Written by the writer thread only
+    uint64_t writeOffset = 0;
+    std::vector<uint32_t> previous;     // Last written grid, the base of the next delta
+    std::vector<uint32_t> delta;
+    std::vector<uint32_t> compressed;
+
+    std::thread writer;
+    std::queue<std::vector<uint32_t>> pending;
+    mutable std::mutex mutex;
+    std::condition_variable workAvailable;
+    std::condition_variable spaceAvailable;
+    std::condition_variable idle;
+    bool writing = false;
+    bool stopping = false;
+    bool finished = false;
+    uint64_t nextGeneration;
+    uint64_t framesWritten = 0;
+    std::exception_ptr error;
+
+    void writerLoop();
+    void writeFrame(std::vector<uint32_t>&& grid);
+    void writeIndex();
+};
+
+// Read side of Recorder
+class Recording
+{
+public:
+    explicit Recording(const std::string& path);
+
+    uint32_t getWidth() const { return header.width; }
+    uint32_t getHeight() const { return header.height; }
+    Rule getRule() const { return Rule { header.birth, header.survival }; }
+    Boundary getBoundary() const { return static_cast<Boundary>(header.boundary); }
+    uint32_t getKeyframeInterval() const { return header.keyframeInterval; }
+    uint64_t getFirstGeneration() const { return header.firstGeneration; }
+    uint64_t getFrameCount() const { return frameOffsets.size(); }
+    uint32_t getWordsPerRow() const { return (header.width + 31) / 32; }
+
+    // Rebuilds the grid of generation, stepping forward from the last one rebuilt when that is on the
+    // way and otherwise from the nearest keyframe before it. Valid until the next call
+    const std::vector<uint32_t>& seek(uint64_t generation);
+
+private:
+    std::unique_ptr<MappedFile> file;
+    Recorder::FileHeader header {};
+    size_t gridWords = 0;
+    std::vector<uint64_t> frameOffsets;
+    std::vector<uint32_t> grid;
+    uint64_t gridFrame = UINT64_MAX; // Frame held in grid
+
+    bool readFrameAt(uint64_t offset, Recorder::FrameHeader& frame) const;
+    void indexFrames();
+    void applyFrame(uint64_t index);
+};
@@ -0,0 +1,382 @@
+#include "RleCodec.h"
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace {
+
+uint32_t ceilDivide(uint64_t value, uint64_t divisor)
+{
+    return static_cast<uint32_t>((value + divisor - 1) / divisor);
+}
+
+} // namespace
+
+RleCodec::EncodeState::~EncodeState()
+{
+    for (wgpu::Buffer* buffer : { &snapshot, &counts, &offsets, &totalReadback, &boundaries, &boundariesReadback }) {
+        if (*buffer) {
+            buffer->destroy();
+            buffer->release();
+        }
+    }
+}
+
+RleCodec::RleCodec(wgpu::Device device, wgpu::Queue queue, PipelineCache& pipelineCache,
+                   const Shader::Defines& defines, uint64_t maxBufferSize, Ready&& ready)
+    : device(device)
+    , queue(queue)
+    , maxBufferSize(maxBufferSize)
+    , ready(std::move(ready))
+{
+    createBindGroupLayouts(pipelineCache);
+    scanParamsBuffer = createBuffer("Scan parameters", sizeof(ScanParams), wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    rleParamsBuffer = createBuffer("Run-length parameters", sizeof(RleParams), wgpu::BufferUsage::Uniform | wgpu::BufferUsage::CopyDst);
+    for (wgpu::Buffer& placeholder : placeholderBuffers) {
+        placeholder = createBuffer("Run-length placeholder", sizeof(uint32_t), wgpu::BufferUsage::Storage);
+    }
+
+    // All six compile in the background, ready fires after the last one
+    pendingPipelines = 6;
+    requestPipeline(pipelineCache, "Scan reduce pipeline", "scan.wgsl", "reduceMain", {}, scanBindGroupLayout, scanReducePipeline);
+    requestPipeline(pipelineCache, "Scan spine pipeline", "scan.wgsl", "spineMain", {}, scanBindGroupLayout, scanSpinePipeline);
+    requestPipeline(pipelineCache, "Scan downsweep pipeline", "scan.wgsl", "downsweepMain", {}, scanBindGroupLayout, scanDownsweepPipeline);
+    requestPipeline(pipelineCache, "Run-length decode pipeline", "rle.wgsl", "decodeMain", defines, rleBindGroupLayout, decodePipeline);
+    requestPipeline(pipelineCache, "Run-length count pipeline", "rle.wgsl", "countMain", defines, rleBindGroupLayout, countPipeline);
+    requestPipeline(pipelineCache, "Run-length emit pipeline", "rle.wgsl", "emitMain", defines, rleBindGroupLayout, emitPipeline);
+}
+
+RleCodec::~RleCodec()
+{
+    // Pipelines and layouts belong to the cache
+    encoding.reset();
+    finishedEncoding.reset();
+    if (scanParamsBuffer) scanParamsBuffer.release();
+    if (rleParamsBuffer) rleParamsBuffer.release();
+    for (wgpu::Buffer& placeholder : placeholderBuffers) if (placeholder) placeholder.release();
+}
+
+void RleCodec::createBindGroupLayouts(PipelineCache& pipelineCache)
+{
+    // Binding 0 holds the parameters, every other binding a storage buffer
+    const auto createLayout = [&pipelineCache](const char* label, uint64_t paramsSize, size_t storageCount, bool firstReadOnly) {
+        std::vector<wgpu::BindGroupLayoutEntry> entries(storageCount + 1);
+        for (size_t i = 0; i < entries.size(); ++i) {
+            entries[i].setDefault();
+            entries[i].binding = static_cast<uint32_t>(i);
+            entries[i].visibility = wgpu::ShaderStage::Compute;
+            entries[i].buffer.type = wgpu::BufferBindingType::Storage;
+        }
+        entries[0].buffer.type = wgpu::BufferBindingType::Uniform;
+        entries[0].buffer.minBindingSize = paramsSize;
+        if (firstReadOnly) entries[1].buffer.type = wgpu::BufferBindingType::ReadOnlyStorage;
+
+        wgpu::BindGroupLayoutDescriptor bindGroupLayoutDesc {};
+        bindGroupLayoutDesc.setDefault();
+        bindGroupLayoutDesc.label = label;
+        bindGroupLayoutDesc.entryCount = entries.size();
+        bindGroupLayoutDesc.entries = entries.data();
+        wgpu::BindGroupLayout layout = pipelineCache.bindGroupLayout(bindGroupLayoutDesc);
+        if (!layout) throw CodecError(std::string("Failed to create ") + label);
+        return layout;
+    };
+
+    // Scan: values (read only), sums, block sums
+    scanBindGroupLayout = createLayout("Scan bind group layout", sizeof(ScanParams), 3, true);
+    // Run-length passes: cells, counts, offsets, boundaries
+    rleBindGroupLayout = createLayout("Run-length bind group layout", sizeof(RleParams), 4, false);
+}
+
+void RleCodec::requestPipeline(PipelineCache& pipelineCache, const char* label, const char* shader, const char* entryPoint,
+                               const Shader::Defines& defines, const wgpu::BindGroupLayout& layout, wgpu::ComputePipeline& target)
+{
+    PipelineCache::Key sourceKey = 0;
+    wgpu::ShaderModule shaderModule = pipelineCache.shaderModule(shader, defines, sourceKey);
+    if (!shaderModule) throw CodecError(std::string("Failed to load ") + shader);
+    wgpu::PipelineLayout pipelineLayout = pipelineCache.pipelineLayout(layout);
+
+    wgpu::ComputePipelineDescriptor pipelineDesc {};
+    pipelineDesc.setDefault();
+    pipelineDesc.label = label;
+    pipelineDesc.layout = pipelineLayout;
+    pipelineDesc.compute.module = shaderModule;
+    pipelineDesc.compute.entryPoint = entryPoint;
+
+    const PipelineCache::Key key = PipelineCache::KeyBuilder()
+        .add(label).add(sourceKey).add(entryPoint)
+        .add(reinterpret_cast<uintptr_t>(static_cast<WGPUPipelineLayout>(pipelineLayout)))
+        .get();
+    pipelineCache.computePipeline(key, pipelineDesc,
+        [this, &target](wgpu::ComputePipeline pipeline, const char* message) {
+            if (failed) return;
+            if (!pipeline) {
+                failed = true;
+                ready(message ? message : "Failed to create run-length pipeline");
+                return;
+            }
+            target = pipeline;
+            if (--pendingPipelines == 0) ready(nullptr);
+        });
+}
+
+wgpu::Buffer RleCodec::createBuffer(const char* label, uint64_t size, wgpu::BufferUsageFlags usage) const
+{
+    if (size > maxBufferSize) {
+        throw CodecError(std::string(label) + " needs " + std::to_string(size) + " bytes, the device allows "
+            + std::to_string(maxBufferSize));
+    }
+    wgpu::BufferDescriptor bufferDesc {};
+    bufferDesc.setDefault();
+    bufferDesc.label = label;
+    bufferDesc.size = std::max<uint64_t>(size, sizeof(uint32_t));
+    bufferDesc.usage = usage;
+    wgpu::Buffer buffer = device.createBuffer(bufferDesc);
+    if (!buffer) throw CodecError(std::string("Failed to create ") + label);
+    return buffer;
+}
+
+wgpu::BindGroup RleCodec::createRleBindGroup(const wgpu::Buffer& cells, const wgpu::Buffer& counts,
+                                             const wgpu::Buffer& offsets, const wgpu::Buffer& boundaries) const
+{
+    std::array<wgpu::BindGroupEntry, 5> entries;
+    const std::array<const wgpu::Buffer*, 5> buffers = { &rleParamsBuffer, &cells, &counts, &offsets, &boundaries };
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i].setDefault();
+        entries[i].binding = static_cast<uint32_t>(i);
+        entries[i].buffer = *buffers[i];
+        entries[i].size = buffers[i]->getSize();
+    }
+
+    wgpu::BindGroupDescriptor bindGroupDesc {};
+    bindGroupDesc.setDefault();
+    bindGroupDesc.label = "Run-length bind group";
+    bindGroupDesc.layout = rleBindGroupLayout;
+    bindGroupDesc.entryCount = entries.size();
+    bindGroupDesc.entries = entries.data();
+    wgpu::BindGroup bindGroup = device.createBindGroup(bindGroupDesc);
+    if (!bindGroup) throw CodecError("Failed to create run-length bind group");
+    return bindGroup;
+}
+
+void RleCodec::recordScan(wgpu::ComputePassEncoder& pass, const wgpu::Buffer& values, const wgpu::Buffer& sums, uint32_t count,
+                          std::vector<wgpu::Buffer>& temporaries, std::vector<wgpu::BindGroup>& bindGroups)
+{
+    const uint32_t blockCount = std::max(1u, ceilDivide(count, SCAN_BLOCK_SIZE));
+    ScanParams params {};
+    params.count = count;
+    params.blockCount = blockCount;
+    queue.writeBuffer(scanParamsBuffer, 0, &params, sizeof(params));
+
+    wgpu::Buffer blockSums = createBuffer("Scan block sums", static_cast<uint64_t>(blockCount) * sizeof(uint32_t), wgpu::BufferUsage::Storage);
+    temporaries.push_back(blockSums);
+
+    std::array<wgpu::BindGroupEntry, 4> entries;
+    const std::array<const wgpu::Buffer*, 4> buffers = { &scanParamsBuffer, &values, &sums, &blockSums };
+    for (size_t i = 0; i < entries.size(); ++i) {
+        entries[i].setDefault();
+        entries[i].binding = static_cast<uint32_t>(i);
+        entries[i].buffer = *buffers[i];
+        entries[i].size = buffers[i]->getSize();
+    }
+    wgpu::BindGroupDescriptor bindGroupDesc {};
+    bindGroupDesc.setDefault();
+    bindGroupDesc.label = "Scan bind group";
+    bindGroupDesc.layout = scanBindGroupLayout;
+    bindGroupDesc.entryCount = entries.size();
+    bindGroupDesc.entries = entries.data();
+    wgpu::BindGroup bindGroup = device.createBindGroup(bindGroupDesc);
+    if (!bindGroup) throw CodecError("Failed to create scan bind group");
+    bindGroups.push_back(bindGroup);
+
+    // One workgroup per block, spread over y once x runs out
+    const uint32_t groupsX = std::min(blockCount, MAX_WORKGROUPS_PER_DIMENSION);
+    const uint32_t groupsY = ceilDivide(blockCount, groupsX);
+    pass.setBindGroup(0, bindGroup, 0, nullptr);
+    pass.setPipeline(scanReducePipeline);
+    pass.dispatchWorkgroups(groupsX, groupsY, 1);
+    pass.setPipeline(scanSpinePipeline);
+    pass.dispatchWorkgroups(1, 1, 1);
+    pass.setPipeline(scanDownsweepPipeline);
+    pass.dispatchWorkgroups(groupsX, groupsY, 1);
+}
+
+void RleCodec::submit(wgpu::CommandEncoder& encoder)
+{
+    wgpu::CommandBuffer commandBuffer = encoder.finish();
+    queue.submit(commandBuffer);
+    commandBuffer.release();
+    encoder.release();
+}
+
+void RleCodec::decode(const wgpu::Buffer& cells, uint32_t gridSize, const Pattern::Runs& runs, uint32_t x, uint32_t y)
+{
+    if (!isReady()) throw CodecError("Decoding before the run-length pipelines are ready");
+
+    wgpu::CommandEncoder encoder = device.createCommandEncoder();
+    encoder.clearBuffer(cells, 0, cells.getSize());
+
+    // Only the part of the pattern inside the grid is decoded
+    const uint32_t visibleWidth = static_cast<uint32_t>(std::min<uint64_t>(runs.width, gridSize - std::min(x, gridSize)));
+    const uint32_t visibleHeight = static_cast<uint32_t>(std::min<uint64_t>(runs.height, gridSize - std::min(y, gridSize)));
+    const uint32_t runCount = static_cast<uint32_t>(runs.lengths.size());
+    if (visibleWidth == 0 || visibleHeight == 0 || runCount == 0) {
+        submit(encoder);
+        return;
+    }
+
+    RleParams params {};
+    params.origin[0] = x;
+    params.origin[1] = y;
+    params.size[0] = runs.width;
+    params.size[1] = runs.height;
+    params.visible[0] = visibleWidth;
+    params.visible[1] = visibleHeight;
+    params.gridSize = gridSize;
+    params.runCount = runCount;
+    queue.writeBuffer(rleParamsBuffer, 0, &params, sizeof(params));
+
+    // The run lengths are the whole upload, their prefix sums never leave the GPU
+    std::vector<wgpu::Buffer> temporaries;
+    std::vector<wgpu::BindGroup> bindGroups;
+    wgpu::Buffer lengths = createBuffer("Run lengths", static_cast<uint64_t>(runCount) * sizeof(uint32_t),
+                                        wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    temporaries.push_back(lengths);
+    queue.writeBuffer(lengths, 0, runs.lengths.data(), runs.lengths.size() * sizeof(uint32_t));
+    wgpu::Buffer starts = createBuffer("Run starts", (static_cast<uint64_t>(runCount) + 1) * sizeof(uint32_t), wgpu::BufferUsage::Storage);
+    temporaries.push_back(starts);
+
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass();
+    recordScan(pass, lengths, starts, runCount, temporaries, bindGroups);
+    bindGroups.push_back(createRleBindGroup(cells, placeholderBuffers[0], starts, placeholderBuffers[1]));
+    pass.setBindGroup(0, bindGroups.back(), 0, nullptr);
+    pass.setPipeline(decodePipeline);
+    const uint32_t groupCount = (x + visibleWidth - 1) / 32 - x / 32 + 1;
+    pass.dispatchWorkgroups(ceilDivide(groupCount, RLE_WORKGROUP_SIZE), ceilDivide(visibleHeight, RLE_WORKGROUP_SIZE), 1);
+    pass.end();
+    pass.release();
+    submit(encoder);
+
+    for (auto& bindGroup : bindGroups) bindGroup.release();
+    for (auto& buffer : temporaries) buffer.release();
+}
+
+void RleCodec::encode(const wgpu::Buffer& cells, uint32_t gridSize, Encoded&& done)
+{
+    if (!isReady()) throw CodecError("Encoding before the run-length pipelines are ready");
+    if (encoding) throw CodecError("An encode is already in flight");
+    // Cell positions are 32-bit on the GPU
+    if (static_cast<uint64_t>(gridSize) * gridSize > UINT32_MAX) {
+        throw CodecError("A " + std::to_string(gridSize) + "x" + std::to_string(gridSize) + " grid has too many cells to encode");
+    }
+    finishedEncoding.reset();
+
+    auto state = std::make_unique<EncodeState>();
+    state->gridSize = gridSize;
+    state->groupCount = gridSize * ceilDivide(gridSize, 32);
+    state->done = std::move(done);
+    state->snapshot = createBuffer("Run-length snapshot", cells.getSize(), wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopyDst);
+    state->counts = createBuffer("Run counts", static_cast<uint64_t>(state->groupCount) * sizeof(uint32_t), wgpu::BufferUsage::Storage);
+    state->offsets = createBuffer("Run offsets", (static_cast<uint64_t>(state->groupCount) + 1) * sizeof(uint32_t),
+                                  wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    state->totalReadback = createBuffer("Run total readback", sizeof(uint32_t), wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+
+    RleParams params {};
+    params.gridSize = gridSize;
+    queue.writeBuffer(rleParamsBuffer, 0, &params, sizeof(params));
+
+    // The simulation keeps stepping while the total is read back, so both passes work on a copy
+    std::vector<wgpu::Buffer> temporaries;
+    std::vector<wgpu::BindGroup> bindGroups;
+    wgpu::CommandEncoder encoder = device.createCommandEncoder();
+    encoder.copyBufferToBuffer(cells, 0, state->snapshot, 0, cells.getSize());
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass();
+    bindGroups.push_back(createRleBindGroup(state->snapshot, state->counts, placeholderBuffers[0], placeholderBuffers[1]));
+    pass.setBindGroup(0, bindGroups.back(), 0, nullptr);
+    pass.setPipeline(countPipeline);
+    pass.dispatchWorkgroups(ceilDivide(ceilDivide(gridSize, 32), RLE_WORKGROUP_SIZE), ceilDivide(gridSize, RLE_WORKGROUP_SIZE), 1);
+    recordScan(pass, state->counts, state->offsets, state->groupCount, temporaries, bindGroups);
+    pass.end();
+    pass.release();
+    encoder.copyBufferToBuffer(state->offsets, static_cast<uint64_t>(state->groupCount) * sizeof(uint32_t),
+                               state->totalReadback, 0, sizeof(uint32_t));
+    submit(encoder);
+    for (auto& bindGroup : bindGroups) bindGroup.release();
+    for (auto& buffer : temporaries) buffer.release();
+
+    encoding = std::move(state);
+    encoding->totalMap = encoding->totalReadback.mapAsync(wgpu::MapMode::Read, 0, sizeof(uint32_t),
+        [this](wgpu::BufferMapAsyncStatus status) {
+            if (status != wgpu::BufferMapAsyncStatus::Success) {
+                finishEncode("Failed to map the run total");
+                return;
+            }
+            std::memcpy(&encoding->boundaryCount, encoding->totalReadback.getConstMappedRange(0, sizeof(uint32_t)), sizeof(uint32_t));
+            encoding->totalReadback.unmap();
+            try {
+                readBoundaries();
+            } catch (const std::exception& e) {
+                finishEncode(e.what());
+            }
+        });
+}
+
+void RleCodec::readBoundaries()
+{
+    EncodeState& state = *encoding;
+    const uint64_t size = static_cast<uint64_t>(state.boundaryCount) * sizeof(uint32_t);
+    state.boundaries = createBuffer("Run boundaries", size, wgpu::BufferUsage::Storage | wgpu::BufferUsage::CopySrc);
+    state.boundariesReadback = createBuffer("Run boundaries readback", size, wgpu::BufferUsage::MapRead | wgpu::BufferUsage::CopyDst);
+    if (state.boundaryCount == 0) {
+        finishEncode(nullptr);
+        return;
+    }
+
+    RleParams params {};
+    params.gridSize = state.gridSize;
+    queue.writeBuffer(rleParamsBuffer, 0, &params, sizeof(params));
+
+    wgpu::BindGroup bindGroup = createRleBindGroup(state.snapshot, placeholderBuffers[0], state.offsets, state.boundaries);
+    wgpu::CommandEncoder encoder = device.createCommandEncoder();
+    wgpu::ComputePassEncoder pass = encoder.beginComputePass();
+    pass.setBindGroup(0, bindGroup, 0, nullptr);
+    pass.setPipeline(emitPipeline);
+    pass.dispatchWorkgroups(ceilDivide(ceilDivide(state.gridSize, 32), RLE_WORKGROUP_SIZE), ceilDivide(state.gridSize, RLE_WORKGROUP_SIZE), 1);
+    pass.end();
+    pass.release();
+    encoder.copyBufferToBuffer(state.boundaries, 0, state.boundariesReadback, 0, size);
+    submit(encoder);
+    bindGroup.release();
+
+    state.boundariesMap = state.boundariesReadback.mapAsync(wgpu::MapMode::Read, 0, size,
+        [this](wgpu::BufferMapAsyncStatus status) {
+            finishEncode(status == wgpu::BufferMapAsyncStatus::Success ? nullptr : "Failed to map the run boundaries");
+        });
+}
+
+void RleCodec::finishEncode(const char* message)
+{
+    // Boundaries are the cells where the state flips, the runs are the gaps between them
+    Pattern::Runs runs;
+    EncodeState& state = *encoding;
+    if (!message) {
+        runs.width = state.gridSize;
+        runs.height = state.gridSize;
+        runs.lengths.reserve(state.boundaryCount + 1);
+        if (state.boundaryCount > 0) {
+            const uint64_t size = static_cast<uint64_t>(state.boundaryCount) * sizeof(uint32_t);
+            const auto* boundaries = static_cast<const uint32_t*>(state.boundariesReadback.getConstMappedRange(0, size));
+            uint32_t previous = 0;
+            for (uint32_t i = 0; i < state.boundaryCount; ++i) {
+                runs.lengths.push_back(boundaries[i] - previous);
+                previous = boundaries[i];
+            }
+            state.boundariesReadback.unmap();
+            // An odd number of flips leaves the last run live up to the end of the grid
+            if (state.boundaryCount % 2) runs.lengths.push_back(state.gridSize * state.gridSize - previous);
+        }
+    }
+
+    Encoded done = std::move(state.done);
+    finishedEncoding = std::move(encoding);
+    done(std::move(runs), message);
+}
@@ -0,0 +1,124 @@
+#pragma once
+#include "webgpu.hpp"
+#include "Pattern.h"
+#include "PipelineCache.h"
+#include "Shader.h"
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+// Run-length decode and encode of cell state on the GPU (rle.wgsl, scan.wgsl).
+// Decoding uploads Pattern::Runs as they are: a prefix sum places every run, then one invocation per
+// group of 32 cells fills it from the runs that reach it, so a sparse pattern costs a few bytes of
+// transfer instead of a whole grid. Encoding counts the runs starting in every group, scans the
+// counts and writes out the run boundaries, so only those are read back.
+class RleCodec
+{
+public:
+    class CodecError : public std::runtime_error {
+        public:
+            CodecError(const std::string& msg)
+                : std::runtime_error("Run-length codec failed: " + msg) {}
+    };
+
+    // Called once every pipeline exists, or with a message on the first failure
+    using Ready = std::function<void(const char* message)>;
+    // Called from the event loop, runs are empty and message is set on failure
+    using Encoded = std::function<void(Pattern::Runs&& runs, const char* message)>;
+
+    // defines select the cell packing, like Life::renderShaderDefines. Buffers the codec allocates
+    // are bounded by maxBufferSize
+    RleCodec(wgpu::Device device, wgpu::Queue queue, PipelineCache& pipelineCache,
+             const Shader::Defines& defines, uint64_t maxBufferSize, Ready&& ready);
+    ~RleCodec();
+    RleCodec(const RleCodec&) = delete;
+    RleCodec& operator=(const RleCodec&) = delete;
+
+    bool isReady() const { return pendingPipelines == 0 && !failed; }
+    bool isEncoding() const { return encoding != nullptr; }
+
+    // Clears cells, a gridSize x gridSize state buffer, and decodes the runs into it with the bottom
+    // left of the pattern at (x, y), clipped to the grid. Pattern rows run top down
+    void decode(const wgpu::Buffer& cells, uint32_t gridSize, const Pattern::Runs& runs, uint32_t x, uint32_t y);
+    // Snapshots cells (which needs CopySrc usage) and encodes the snapshot, whole grid, top row first.
+    // One encode runs at a time
+    void encode(const wgpu::Buffer& cells, uint32_t gridSize, Encoded&& done);
+
+private:
+    // Must match the WGSL structs
+    struct ScanParams {
+        uint32_t count;
+        uint32_t blockCount;
+        uint32_t padding[2];
+    };
+    static_assert(sizeof(ScanParams) == 16, "ScanParams must match the WGSL struct layout");
+    struct RleParams {
+        uint32_t origin[2];
+        uint32_t size[2];
+        uint32_t visible[2];
+        uint32_t gridSize;
+        uint32_t runCount;
+    };
+    static_assert(sizeof(RleParams) == 32, "RleParams must match the WGSL struct layout");
+
+    static constexpr uint32_t SCAN_BLOCK_SIZE = 1024;   // Values per scan workgroup
+    static constexpr uint32_t RLE_WORKGROUP_SIZE = 8;   // Tile edge of the decode and encode passes
+    static constexpr uint32_t MAX_WORKGROUPS_PER_DIMENSION = 65535;
+
+    // Buffers of an encode in flight, released once the boundaries are read back
+    struct EncodeState {
+        uint32_t gridSize = 0;
+        uint32_t groupCount = 0;
+        uint32_t boundaryCount = 0;
+        Encoded done;
+        wgpu::Buffer snapshot{nullptr};
+        wgpu::Buffer counts{nullptr};
+        wgpu::Buffer offsets{nullptr};
+        wgpu::Buffer totalReadback{nullptr};
+        wgpu::Buffer boundaries{nullptr};
+        wgpu::Buffer boundariesReadback{nullptr};
+        std::unique_ptr<wgpu::BufferMapCallback> totalMap;
+        std::unique_ptr<wgpu::BufferMapCallback> boundariesMap;
+        ~EncodeState();
+    };
+
+    wgpu::Device device;
+    wgpu::Queue queue;
+    uint64_t maxBufferSize;
+    wgpu::BindGroupLayout scanBindGroupLayout{nullptr};
+    wgpu::BindGroupLayout rleBindGroupLayout{nullptr};
+    wgpu::ComputePipeline scanReducePipeline{nullptr};
+    wgpu::ComputePipeline scanSpinePipeline{nullptr};
+    wgpu::ComputePipeline scanDownsweepPipeline{nullptr};
+    wgpu::ComputePipeline decodePipeline{nullptr};
+    wgpu::ComputePipeline countPipeline{nullptr};
+    wgpu::ComputePipeline emitPipeline{nullptr};
+    wgpu::Buffer scanParamsBuffer{nullptr};
+    wgpu::Buffer rleParamsBuffer{nullptr};
+    // Bound to the bindings a pass doesn't use, two since writable bindings may not alias
+    std::array<wgpu::Buffer, 2> placeholderBuffers{ wgpu::Buffer{nullptr}, wgpu::Buffer{nullptr} };
+    int pendingPipelines = 0;
+    bool failed = false;
+    Ready ready;
+
+    // The map callback that finishes an encode can't destroy its own handle, so the state is parked
+    // here until the next encode
+    std::unique_ptr<EncodeState> encoding;
+    std::unique_ptr<EncodeState> finishedEncoding;
+
+    void createBindGroupLayouts(PipelineCache& pipelineCache);
+    void requestPipeline(PipelineCache& pipelineCache, const char* label, const char* shader, const char* entryPoint,
+                         const Shader::Defines& defines, const wgpu::BindGroupLayout& layout, wgpu::ComputePipeline& target);
+    wgpu::Buffer createBuffer(const char* label, uint64_t size, wgpu::BufferUsageFlags usage) const;
+    wgpu::BindGroup createRleBindGroup(const wgpu::Buffer& cells, const wgpu::Buffer& counts,
+                                       const wgpu::Buffer& offsets, const wgpu::Buffer& boundaries) const;
+    // Exclusive prefix sums of count values into sums (count + 1 entries, the last one the total)
+    void recordScan(wgpu::ComputePassEncoder& pass, const wgpu::Buffer& values, const wgpu::Buffer& sums, uint32_t count,
+                    std::vector<wgpu::Buffer>& temporaries, std::vector<wgpu::BindGroup>& bindGroups);
+    void submit(wgpu::CommandEncoder& encoder);
+    void readBoundaries();
+    void finishEncode(const char* message);
+};
@@ -1,8 +1,118 @@
 #include "Shader.h"
+#include "EmbeddedShaders.h"
+#include <algorithm>
+#include <cctype>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 
+namespace {
+
+std::string trim(const std::string& text)
+{
+    const size_t first = text.find_first_not_of(" \t\r");
+    if (first == std::string::npos) return "";
+    const size_t last = text.find_last_not_of(" \t\r");
+    return text.substr(first, last - first + 1);
+}
+
+bool isIdentifierStart(char c) { return std::isalpha(static_cast<unsigned char>(c)) || c == '_'; }
+bool isIdentifierChar(char c) { return std::isalnum(static_cast<unsigned char>(c)) || c == '_'; }
+
+// Replaces whole identifiers that are defined, leaving everything else untouched
+std::string substitute(const std::string& line, const Shader::Defines& symbols)
+{
+    std::string result;
+    result.reserve(line.size());
+    for (size_t i = 0; i < line.size();) {
+        // Skip numeric literals such as 1u or 0x8u whole, their suffixes aren't identifiers
+        if (std::isdigit(static_cast<unsigned char>(line[i]))) {
+            const size_t start = i;
+            while (i < line.size() && isIdentifierChar(line[i])) ++i;
+            result.append(line, start, i - start);
+        } else if (isIdentifierStart(line[i])) {
+            const size_t start = i;
+            while (i < line.size() && isIdentifierChar(line[i])) ++i;
+            const std::string identifier = line.substr(start, i - start);
+            const auto symbol = symbols.find(identifier);
+            result += symbol != symbols.end() ? symbol->second : identifier;
+        } else {
+            result += line[i++];
+        }
+    }
+    return result;
+}
+
+// Resolves a symbol to its value (undefined names are 0, as in C) and parses it as an integer
+bool toInteger(const std::string& token, const Shader::Defines& symbols, long long& value)
+{
+    std::string text = trim(token);
+    const auto symbol = symbols.find(text);
+    if (symbol != symbols.end()) text = trim(symbol->second);
+    else if (!text.empty() && isIdentifierStart(text[0])) text = "0";
+
+    // Drop WGSL suffixes (u, i) so 8u and 8 compare equal
+    while (!text.empty() && (text.back() == 'u' || text.back() == 'i')) text.pop_back();
+    try {
+        size_t parsed = 0;
+        value = std::stoll(text, &parsed, 0);
+        return parsed == text.size();
+    } catch (const std::exception&) {
+        return false;
+    }
+}
+
+bool evaluateTerm(const std::string& term, const Shader::Defines& symbols)
+{
+    const std::string text = trim(term);
+    if (!text.empty() && text[0] == '!' && (text.size() < 2 || text[1] != '=')) {
+        return !evaluateTerm(text.substr(1), symbols);
+    }
+    if (text.rfind("defined", 0) == 0) {
+        const size_t open = text.find('(');
+        const size_t close = text.find(')');
+        if (open == std::string::npos || close == std::string::npos || close < open) {
+            throw Shader::PreprocessError("Malformed defined() in: " + text);
+        }
+        return symbols.count(trim(text.substr(open + 1, close - open - 1))) > 0;
+    }
+    for (const char* op : { "==", "!=" }) {
+        const size_t position = text.find(op);
+        if (position == std::string::npos) continue;
+        const std::string lhs = text.substr(0, position);
+        const std::string rhs = text.substr(position + 2);
+        long long left = 0, right = 0;
+        bool equal;
+        if (toInteger(lhs, symbols, left) && toInteger(rhs, symbols, right)) {
+            equal = left == right;
+        } else {
+            equal = substitute(trim(lhs), symbols) == substitute(trim(rhs), symbols);
+        }
+        return (op[0] == '=') == equal;
+    }
+    long long value = 0;
+    if (!toInteger(text, symbols, value)) throw Shader::PreprocessError("Cannot evaluate: " + text);
+    return value != 0;
+}
+
+// Splits on || first, then &&, so && binds tighter
+bool evaluate(const std::string& expression, const Shader::Defines& symbols)
+{
+    const size_t orPosition = expression.find("||");
+    if (orPosition != std::string::npos) {
+        return evaluate(expression.substr(0, orPosition), symbols) 
+            || evaluate(expression.substr(orPosition + 2), symbols);
+    }
+    const size_t andPosition = expression.find("&&");
+    if (andPosition != std::string::npos) {
+        return evaluate(expression.substr(0, andPosition), symbols) 
+            && evaluate(expression.substr(andPosition + 2), symbols);
+    }
+    return evaluateTerm(expression, symbols);
+}
+
+} // namespace
+
 std::string Shader::loadShaderCode(const std::string& filepath) {
     std::ifstream file(filepath);
     if (!file.is_open()) {
@@ -15,15 +125,137 @@ std::string Shader::loadShaderCode(const std::string& filepath) {
     return buffer.str();
 }
 
+const char* Shader::embeddedSource(const std::string& name) {
+    for (const auto& shader : EMBEDDED_SHADERS) {
+        if (shader.name == name) return shader.source;
+    }
+    return nullptr;
+}
+
+std::string Shader::loadSource(const std::string& name) {
+#ifdef LIFE_SHADER_HOT_RELOAD
+    std::string code = loadShaderCode(std::string(SHADER_DIR) + "/" + name);
+    if (!code.empty()) return code;
+    std::cerr << "Falling back to embedded shader: " << name << std::endl;
+#endif
+    const char* source = embeddedSource(name);
+    if (!source) throw PreprocessError("Unknown shader " + name);
+    return source;
+}
+
+wgpu::ShaderModule Shader::loadModule(wgpu::Device device, const std::string& name, const Defines& defines) {
+    return createFromCode(device, preprocess(name, defines));
+}
+
+std::string Shader::preprocess(const std::string& name, const Defines& defines) {
+    Defines symbols = defines;
+    std::string output;
+    std::vector<std::string> includeStack;
+    preprocessInto(name, symbols, output, includeStack);
+    return output;
+}
+
+void Shader::preprocessInto(const std::string& name, Defines& symbols, std::string& output,
+                            std::vector<std::string>& includeStack) {
+    if (std::find(includeStack.begin(), includeStack.end(), name) != includeStack.end()) {
+        throw PreprocessError("Recursive include of " + name);
+    }
+    includeStack.push_back(name);
+
+    // One entry per open #if: whether the enclosing block is emitted, whether this branch is,
+    // and whether an earlier branch of the chain was already taken
+    struct Condition {
+        bool parentActive;
+        bool active;
+        bool taken;
+    };
+    std::vector<Condition> conditions;
+    auto isActive = [&conditions]() { return conditions.empty() || conditions.back().active; };
+
+    std::istringstream lines(loadSource(name));
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(lines, line)) {
+        ++lineNumber;
+        auto fail = [&](const std::string& msg) {
+            throw PreprocessError(name + ":" + std::to_string(lineNumber) + ": " + msg);
+        };
+
+        const size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] != '#') {
+            if (isActive()) {
+                output += substitute(line, symbols);
+                output += '\n';
+            }
+            continue;
+        }
+
+        std::istringstream directive(line.substr(first + 1));
+        std::string keyword;
+        directive >> keyword;
+        std::string argument;
+        std::getline(directive, argument);
+        argument = trim(argument);
+
+        if (keyword == "if" || keyword == "ifdef" || keyword == "ifndef") {
+            const bool parentActive = isActive();
+            bool value = false;
+            // Conditions inside skipped blocks may reference anything, don't evaluate them
+            if (parentActive) {
+                value = keyword == "if" ? evaluate(argument, symbols) 
+                                        : (symbols.count(argument) > 0) == (keyword == "ifdef");
+            }
+            conditions.push_back({ parentActive, parentActive && value, value });
+        } else if (keyword == "elif") {
+            if (conditions.empty()) fail("#elif without #if");
+            Condition& condition = conditions.back();
+            const bool value = condition.parentActive && !condition.taken && evaluate(argument, symbols);
+            condition.active = value;
+            condition.taken = condition.taken || value;
+        } else if (keyword == "else") {
+            if (conditions.empty()) fail("#else without #if");
+            Condition& condition = conditions.back();
+            condition.active = condition.parentActive && !condition.taken;
+            condition.taken = true;
+        } else if (keyword == "endif") {
+            if (conditions.empty()) fail("#endif without #if");
+            conditions.pop_back();
+        } else if (!isActive()) {
+            continue;
+        } else if (keyword == "define") {
+            const size_t split = argument.find_first_of(" \t");
+            const std::string symbol = argument.substr(0, split);
+            if (symbol.empty()) fail("#define without a name");
+            symbols[symbol] = split == std::string::npos ? "" : trim(argument.substr(split));
+        } else if (keyword == "undef") {
+            symbols.erase(argument);
+        } else if (keyword == "include") {
+            if (argument.size() < 2 || argument.front() != '"' || argument.back() != '"') {
+                fail("#include expects a quoted file name");
+            }
+            preprocessInto(argument.substr(1, argument.size() - 2), symbols, output, includeStack);
+        } else {
+            fail("Unknown directive #" + keyword);
+        }
+    }
+    if (!conditions.empty()) throw PreprocessError(name + ": Unterminated #if");
+
+    includeStack.pop_back();
+}
+
 wgpu::ShaderModule Shader::loadModuleFromFile(wgpu::Device device, const std::string& filepath) {
     std::string code = loadShaderCode(filepath);
     return createFromCode(device, code);
 }
 
 wgpu::ShaderModule Shader::createFromCode(wgpu::Device device, const std::string& wgslCode) {
+    return createFromCode(device, wgslCode.c_str());
+}
+
+wgpu::ShaderModule Shader::createFromCode(wgpu::Device device, const char* wgslCode) {
     wgpu::ShaderModuleWGSLDescriptor wgslDesc {};
     wgslDesc.setDefault();
-    wgslDesc.code = wgslCode.c_str();
+    wgslDesc.code = wgslCode;
 
     wgpu::ShaderModuleDescriptor shaderDesc {};
     shaderDesc.setDefault();
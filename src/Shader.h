@@ -1,13 +1,39 @@
 #pragma once
 
 #include "webgpu.hpp"
+#include <map>
+#include <stdexcept>
 #include <string>
+#include <vector>
 
 class Shader {
 public:
+    // Preprocessor symbols, the values are pasted into the WGSL verbatim (e.g. "8u", "0x8u")
+    using Defines = std::map<std::string, std::string>;
+
+    class PreprocessError : public std::runtime_error {
+        public:
+            PreprocessError(const std::string& msg)
+                : std::runtime_error("Shader preprocessing failed: " + msg) {}
+    };
+
+    // Loads a shader from src/shaders by file name and preprocesses it with the given defines.
+    // Sources are embedded at build time, builds with LIFE_SHADER_HOT_RELOAD read SHADER_DIR/name
+    // first so edits apply on restart
+    static wgpu::ShaderModule loadModule(wgpu::Device device, const std::string& name, const Defines& defines = {});
     static wgpu::ShaderModule loadModuleFromFile(wgpu::Device device, const std::string& filepath);
     static wgpu::ShaderModule createFromCode(wgpu::Device device, const std::string& wgslCode);
+    static wgpu::ShaderModule createFromCode(wgpu::Device device, const char* wgslCode);
+
+    // Resolves #include "file", #define/#undef, #if/#ifdef/#ifndef/#elif/#else/#endif and replaces
+    // every defined name in the remaining lines by its value, so each variant is plain constant WGSL.
+    // #if understands defined(NAME), !, ==, !=, && and || over integers and defined names
+    static std::string preprocess(const std::string& name, const Defines& defines);
     
 private:
     static std::string loadShaderCode(const std::string& filepath);
-};
\ No newline at end of file
+    static const char* embeddedSource(const std::string& name);
+    static std::string loadSource(const std::string& name);
+    static void preprocessInto(const std::string& name, Defines& symbols, std::string& output,
+                               std::vector<std::string>& includeStack);
+};
@@ -0,0 +1,23 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+
+// Four 32-bit words per operation. GCC and Clang lower these vector types to SSE/NEON natively and
+// to wasm SIMD with -msimd128 (scalar code otherwise), and accept scalars as broadcast operands
+typedef uint32_t WordVector __attribute__((vector_size(16)));
+constexpr uint32_t VECTOR_WORDS = sizeof(WordVector) / sizeof(uint32_t);
+
+// Unaligned access, Word is uint32_t or WordVector
+template <typename Word>
+Word loadWords(const uint32_t* words)
+{
+    Word word;
+    std::memcpy(&word, words, sizeof(Word));
+    return word;
+}
+
+template <typename Word>
+void storeWords(uint32_t* words, const Word& word)
+{
+    std::memcpy(words, &word, sizeof(Word));
+}
@@ -0,0 +1,52 @@
+#include "Simulation.h"
+#include <stdexcept>
+
+Rule Rule::parse(const std::string& text)
+{
+    Rule rule { 0, 0 };
+    uint16_t* mask = nullptr;
+    for (char c : text) {
+        if (c == 'B' || c == 'b') mask = &rule.birth;
+        else if (c == 'S' || c == 's') mask = &rule.survival;
+        else if (c >= '0' && c <= '8' && mask) *mask |= static_cast<uint16_t>(1 << (c - '0'));
+        else if (c != '/') throw std::invalid_argument("Rule expects B/S notation, got " + text);
+    }
+    return rule;
+}
+
+std::string Rule::toString() const
+{
+    std::string text = "B";
+    for (int n = 0; n <= 8; ++n) if (birth & (1 << n)) text += static_cast<char>('0' + n);
+    text += "/S";
+    for (int n = 0; n <= 8; ++n) if (survival & (1 << n)) text += static_cast<char>('0' + n);
+    return text;
+}
+
+uint64_t hashCells(const uint32_t* words, size_t wordCount)
+{
+    constexpr uint64_t OFFSET_BASIS = 0xcbf29ce484222325ull;
+    constexpr uint64_t PRIME = 0x100000001b3ull;
+    // Four interleaved lanes taking two words per multiply, so consecutive multiplies don't wait on
+    // each other
+    uint64_t lanes[4] = { OFFSET_BASIS, OFFSET_BASIS ^ 1, OFFSET_BASIS ^ 2, OFFSET_BASIS ^ 3 };
+    size_t i = 0;
+    for (; i + 8 <= wordCount; i += 8) {
+        for (size_t lane = 0; lane < 4; ++lane) {
+            lanes[lane] ^= words[i + lane * 2] | (static_cast<uint64_t>(words[i + lane * 2 + 1]) << 32);
+            lanes[lane] *= PRIME;
+        }
+    }
+    for (; i < wordCount; ++i) {
+        lanes[0] ^= words[i];
+        lanes[0] *= PRIME;
+    }
+
+    uint64_t hash = OFFSET_BASIS ^ wordCount;
+    for (uint64_t lane : lanes) {
+        hash ^= lane;
+        hash *= PRIME;
+        hash ^= hash >> 32;
+    }
+    return hash;
+}
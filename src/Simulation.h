@@ -0,0 +1,23 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Simulation parameters shared by the GPU (Life) and CPU (CpuLife) engines
+
+enum class Boundary { Torus, Dead };
+
+struct Rule {
+    uint16_t birth = 1 << 3;                 // Bit n: an inactive cell with n neighbors becomes active
+    uint16_t survival = (1 << 2) | (1 << 3); // Bit n: an active cell with n neighbors stays active
+
+    // B/S notation, e.g. B3/S23 (Conway) or B36/S23 (HighLife). Throws std::invalid_argument
+    static Rule parse(const std::string& text);
+    std::string toString() const;
+    bool operator==(const Rule& other) const { return birth == other.birth && survival == other.survival; }
+};
+
+// State hash of a bitpacked grid (32 cells per word, row y = 0 first, as CpuLife::copyCells and
+// Life::readCells return it), equal across engines and packings: 64-bit FNV-1a steps over pairs of
+// words in four interleaved lanes, folded together at the end. Cheap enough to hash every generation
+uint64_t hashCells(const uint32_t* words, size_t wordCount);
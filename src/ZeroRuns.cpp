@@ -0,0 +1,54 @@
+#include "ZeroRuns.h"
+#include <algorithm>
+
+void ZeroRuns::compress(const uint32_t* words, size_t count, std::vector<uint32_t>& out)
+{
+    out.clear();
+    size_t i = 0;
+    while (i < count) {
+        const size_t zerosBegin = i;
+        while (i < count && words[i] == 0) ++i;
+        const size_t literalsBegin = i;
+        // A single empty word between literals costs less inline than as a new pair
+        while (i < count && (words[i] != 0 || (i + 1 < count && words[i + 1] != 0))) ++i;
+        out.push_back(static_cast<uint32_t>(literalsBegin - zerosBegin));
+        out.push_back(static_cast<uint32_t>(i - literalsBegin));
+        out.insert(out.end(), words + literalsBegin, words + i);
+        if (out.size() >= count) return;
+    }
+}
+
+bool ZeroRuns::expand(const uint32_t* stored, size_t storedCount, uint32_t* words, size_t count)
+{
+    return decode<false>(stored, storedCount, words, count);
+}
+
+bool ZeroRuns::applyXor(const uint32_t* stored, size_t storedCount, uint32_t* words, size_t count)
+{
+    return decode<true>(stored, storedCount, words, count);
+}
+
+template <bool Xor>
+bool ZeroRuns::decode(const uint32_t* stored, size_t storedCount, uint32_t* words, size_t count)
+{
+    size_t read = 0;
+    size_t written = 0;
+    while (read + 2 <= storedCount) {
+        const size_t zeros = stored[read];
+        const size_t literals = stored[read + 1];
+        read += 2;
+        if (zeros > count - written || literals > count - written - zeros || literals > storedCount - read) return false;
+        if (!Xor) std::fill(words + written, words + written + zeros, 0u);
+        written += zeros;
+        for (size_t i = 0; i < literals; ++i) {
+            if (Xor) {
+                words[written + i] ^= stored[read + i];
+            } else {
+                words[written + i] = stored[read + i];
+            }
+        }
+        written += literals;
+        read += literals;
+    }
+    return read == storedCount && written == count;
+}
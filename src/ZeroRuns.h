@@ -0,0 +1,22 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Word-level run-length coding of bitpacked cells: pairs of (empty words, literal words) counts, each
+// followed by its literal words. Sparse grids, settled grids and the XOR of consecutive generations
+// are mostly empty words, so this shrinks them at memory speed without a compression library
+class ZeroRuns
+{
+public:
+    // Gives up once out reaches count words, callers then store the words as they are
+    static void compress(const uint32_t* words, size_t count, std::vector<uint32_t>& out);
+    // Decodes into count words, false if stored isn't a valid encoding of exactly count words
+    static bool expand(const uint32_t* stored, size_t storedCount, uint32_t* words, size_t count);
+    // XORs the decoded words into words, touching only the literals
+    static bool applyXor(const uint32_t* stored, size_t storedCount, uint32_t* words, size_t count);
+
+private:
+    template <bool Xor>
+    static bool decode(const uint32_t* stored, size_t storedCount, uint32_t* words, size_t count);
+};
@@ -1,13 +1,18 @@
 #define WEBGPU_CPP_IMPLEMENTATION
 #include "webgpu.hpp"
 #include "Life.h"
-
-static constexpr int FPS = 0;
-static constexpr bool SIMULATE_INFINITE_LOOP = true;
+#include "Platform.h"
+#include "Recorder.h"
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
 
 // Global pointer to access from C callback
 static Life* g_life = nullptr;
 
+#if __EMSCRIPTEN__
 // Emscripten exposed function, called during window resize
 extern "C" {
     EMSCRIPTEN_KEEPALIVE
@@ -16,28 +21,217 @@ extern "C" {
             g_life->handleResize();
         }
     }
+
+    // Keyboard controls from index.html, errors are reported rather than thrown into JavaScript
+    EMSCRIPTEN_KEEPALIVE
+    void togglePause() {
+        if (g_life) g_life->setPaused(!g_life->isPaused());
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void toggleAdaptiveResolution() {
+        if (!g_life) return;
+        try {
+            g_life->setAdaptiveResolution(!g_life->isAdaptiveResolution());
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void stepBackward() {
+        if (!g_life) return;
+        try {
+            g_life->stepBackward();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
+
+    EMSCRIPTEN_KEEPALIVE
+    void stepForward() {
+        if (!g_life) return;
+        try {
+            g_life->stepForward();
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << std::endl;
+        }
+    }
 }
+#endif
 
-int main() {
+// Command line options, only meaningful for native (headless) runs except --adaptive, which the page
+// passes when its URL has ?adaptive
+// usage: life [--frames N] [--size WxH] [--export DIR|FILE.y4m] [--threads N] [--software] [--adaptive]
+//             [--grid N] [--rule B3/S23] [--dead-edges] [--packed] [--workgroup N] [--steps-per-update N]
+//             [--ring-depth N] [--seed N] [--density F] [--cpu-seed] [--pattern FILE.rle|.cells|.lif]
+//             [--save-rle FILE.rle] [--checkpoint FILE] [--save-checkpoint FILE [--checkpoint-every N]]
+//             [--record FILE [--keyframe-every N]] [--history MB]
+struct Options {
+    Life::Config config;
+    uint64_t frameCount = 0; // 0 runs until the page is closed
+    std::string exportPath;
+    std::string saveRlePath; // The last generation, encoded on the GPU
+    std::string checkpointPath; // Saved after the last frame, and every checkpointInterval frames if set
+    uint64_t checkpointInterval = 0;
+    std::string recordPath; // Every generation, read back from the GPU as it is displayed
+    uint32_t keyframeInterval = 256;
+    unsigned exportThreads = std::thread::hardware_concurrency();
+};
+
+static Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    options.config.headless = !Platform::hasSurface();
+    if (options.config.headless) options.frameCount = 1000;
+    bool ruleSet = false; // An explicit --rule wins over the one in a pattern file
+    bool historySet = false;
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) {
+            options.frameCount = std::stoull(argv[++i]);
+        } else if (arg == "--size" && hasValue) {
+            const std::string size = argv[++i];
+            const size_t separator = size.find('x');
+            if (separator == std::string::npos) throw std::invalid_argument("--size expects WxH, got " + size);
+            options.config.frameWidth = static_cast<uint32_t>(std::stoul(size.substr(0, separator)));
+            options.config.frameHeight = static_cast<uint32_t>(std::stoul(size.substr(separator + 1)));
+        } else if (arg == "--export" && hasValue) {
+            options.exportPath = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            options.exportThreads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--software") {
+            options.config.forceFallbackAdapter = true;
+        } else if (arg == "--adaptive") {
+            options.config.adaptiveResolution = true;
+        } else if (arg == "--grid" && hasValue) {
+            options.config.gridSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--rule" && hasValue) {
+            options.config.rule = Rule::parse(argv[++i]);
+            ruleSet = true;
+        } else if (arg == "--dead-edges") {
+            options.config.boundary = Life::Boundary::Dead;
+        } else if (arg == "--packed") {
+            options.config.packing = Life::Packing::Bits;
+        } else if (arg == "--workgroup" && hasValue) {
+            options.config.workgroupSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--steps-per-update" && hasValue) {
+            options.config.stepsPerUpdate = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--ring-depth" && hasValue) {
+            options.config.stateRingDepth = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            options.config.seed = std::stoull(argv[++i]);
+        } else if (arg == "--density" && hasValue) {
+            options.config.density = std::stof(argv[++i]);
+        } else if (arg == "--cpu-seed") {
+            options.config.seedOnCpu = true;
+        } else if (arg == "--pattern" && hasValue) {
+            options.config.pattern = std::make_shared<const Pattern::Runs>(Pattern::loadRuns(argv[++i]));
+            if (!ruleSet && options.config.pattern->rule) options.config.rule = *options.config.pattern->rule;
+        } else if (arg == "--checkpoint" && hasValue) {
+            options.config.checkpoint = std::make_shared<const Checkpoint>(argv[++i]);
+        } else if (arg == "--save-checkpoint" && hasValue) {
+            options.checkpointPath = argv[++i];
+        } else if (arg == "--checkpoint-every" && hasValue) {
+            options.checkpointInterval = std::stoull(argv[++i]);
+        } else if (arg == "--record" && hasValue) {
+            options.recordPath = argv[++i];
+        } else if (arg == "--keyframe-every" && hasValue) {
+            options.keyframeInterval = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--history" && hasValue) {
+            options.config.historyBudget = static_cast<size_t>(std::stoull(argv[++i])) << 20;
+            historySet = true;
+        } else if (arg == "--save-rle" && hasValue) {
+            options.saveRlePath = argv[++i];
+        } else {
+            throw std::invalid_argument("Unknown or incomplete option " + arg);
+        }
+    }
+    // Nobody rewinds a headless run, so it only keeps history when asked to
+    if (options.config.headless && !historySet) options.config.historyBudget = 0;
+    return options;
+}
+
+int main(int argc, char** argv) {
     try {
-        Life life {};
+        const Options options = parseOptions(argc, argv);
+        Life life { options.config };
         g_life = &life;
-        auto renderLoop = [&life]() {
-            life.renderFrame();
+        if (options.config.seed == 0 && !options.config.checkpoint) {
+            std::cout << "Seed: " << life.getConfig().seed << std::endl;
+        }
+
+        std::unique_ptr<FrameExporter> exporter;
+        if (!options.exportPath.empty()) {
+            const bool y4m = options.exportPath.size() > 4
+                && options.exportPath.compare(options.exportPath.size() - 4, 4, ".y4m") == 0;
+            exporter = std::make_unique<FrameExporter>(
+                y4m ? FrameExporter::Format::Y4m : FrameExporter::Format::Png,
+                options.exportPath,
+                options.exportThreads
+            );
+            life.setFrameExporter(exporter.get());
+        }
+
+        // Every generation from the first displayed one on, read back by Life as it is drawn. The grid
+        // (and a checkpoint's generation) only exists once Life is ready, so this waits for it
+        std::unique_ptr<Recorder> recorder;
+        if (!options.recordPath.empty()) {
+            if (!Platform::canBlock()) throw std::invalid_argument("--record is only supported natively");
+            life.waitUntilReady();
+            Recorder::Config recorderConfig;
+            recorderConfig.width = life.getConfig().gridSize;
+            recorderConfig.height = life.getConfig().gridSize;
+            recorderConfig.rule = life.getConfig().rule;
+            recorderConfig.boundary = life.getConfig().boundary;
+            recorderConfig.firstGeneration = life.getGeneration();
+            recorderConfig.keyframeInterval = options.keyframeInterval;
+            recorder = std::make_unique<Recorder>(options.recordPath, recorderConfig);
+            life.setCellRecorder(recorder.get());
+        }
+
+        // Errors surface from inside the loop callback, where the browser can't propagate them
+        uint64_t frame = 0;
+        bool failed = false;
+        bool firstFrameReported = false;
+        const std::function<bool()> renderLoop = [&]() {
+            try {
+                life.renderFrame();
+                if (!firstFrameReported && life.getTimeToFirstFrameMs() > 0.0f) {
+                    std::cout << "Time to first frame: " << life.getTimeToFirstFrameMs() << " ms" << std::endl;
+                    firstFrameReported = true;
+                }
+                if (life.isReady() && !options.checkpointPath.empty() && options.checkpointInterval > 0
+                    && (frame + 1) % options.checkpointInterval == 0) {
+                    life.saveCheckpoint(options.checkpointPath);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Fatal error: " << e.what() << std::endl;
+                failed = true;
+                return false;
+            }
+            if (!life.isReady()) return true;
+            return options.frameCount == 0 || ++frame < options.frameCount;
         };
-        emscripten_set_main_loop_arg(
-            [](void* arg) {
-                auto* loop = static_cast<decltype(renderLoop)*>(arg);
-                (*loop)();
-            },
-            &renderLoop,
-            FPS,
-            SIMULATE_INFINITE_LOOP
-        );
+        Platform::runLoop(renderLoop);
+
+        // Only reached natively, the browser loop never returns
+        if (failed) return 1;
+        life.flushReadbacks();
+        if (exporter) exporter->finish();
+        if (recorder) recorder->finish();
+        if (!options.checkpointPath.empty()) life.saveCheckpoint(options.checkpointPath);
+        if (!options.saveRlePath.empty()) {
+            std::ofstream file(options.saveRlePath, std::ios::binary);
+            file << Pattern::writeRle(life.readRuns());
+            if (!file) throw std::runtime_error("Failed to write " + options.saveRlePath);
+        }
     } catch(const std::exception& e) {
         std::cerr << "Fatal error: " << e.what() << std::endl;
         return 1;
     }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,237 @@
+// Platform*.cpp use the wgpu wrappers, whose definitions live in the entry point
+#define WEBGPU_CPP_IMPLEMENTATION
+#include "webgpu.hpp"
+#include "CpuLife.h"
+#include "Life.h"
+#include "Pattern.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <bit>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Headless throughput runs of either engine: N generations with no surface, rendering or frame loop,
+// then throughput, final population and state hash. Native only
+// usage: life-batch [--engine gpu|cpu] [--generations N] [--warmup N] [--grid N]
+//                   [--kernel u32|bits (gpu), vector|swar32 (cpu)] [--workgroup N] [--threads N]
+//                   [--rule B3/S23] [--dead-edges] [--seed N] [--density F]
+//                   [--pattern FILE.rle|.cells|.lif] [--checkpoint FILE] [--software]
+struct Options {
+    bool gpu = true;
+    uint64_t generations = 1000;
+    uint64_t warmup = 0;       // Untimed generations first (pipeline warm-up, caches, clocks)
+    uint32_t gridSize = 1024;  // Square, like the GPU engine
+    std::string kernel;        // Engine default when empty
+    uint32_t workgroupSize = 8;
+    unsigned threads = std::thread::hardware_concurrency();
+    Rule rule {};
+    Boundary boundary = Boundary::Torus;
+    uint64_t seed = 1;         // Fixed, so runs with the same options end in the same hash
+    float density = 0.5f;
+    std::shared_ptr<const Pattern::Runs> runs; // GPU, decoded on the device
+    std::shared_ptr<const Pattern> pattern;    // CPU
+    std::shared_ptr<const Checkpoint> checkpoint;
+    bool software = false;
+};
+
+struct Result {
+    std::string description;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint64_t generation = 0;
+    double seconds = 0.0;
+    uint64_t stateBytes = 0;   // Read and written once per generation
+    std::vector<uint32_t> cells;
+};
+
+static Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    bool ruleSet = false; // An explicit --rule wins over the one in a pattern file
+    std::string patternPath;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--engine" && hasValue) {
+            const std::string engine = argv[++i];
+            if (engine != "gpu" && engine != "cpu") throw std::invalid_argument("--engine expects gpu or cpu, got " + engine);
+            options.gpu = engine == "gpu";
+        } else if (arg == "--generations" && hasValue) {
+            options.generations = std::stoull(argv[++i]);
+        } else if (arg == "--warmup" && hasValue) {
+            options.warmup = std::stoull(argv[++i]);
+        } else if (arg == "--grid" && hasValue) {
+            options.gridSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--kernel" && hasValue) {
+            options.kernel = argv[++i];
+        } else if (arg == "--workgroup" && hasValue) {
+            options.workgroupSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--rule" && hasValue) {
+            options.rule = Rule::parse(argv[++i]);
+            ruleSet = true;
+        } else if (arg == "--dead-edges") {
+            options.boundary = Boundary::Dead;
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--density" && hasValue) {
+            options.density = std::stof(argv[++i]);
+        } else if (arg == "--pattern" && hasValue) {
+            patternPath = argv[++i];
+        } else if (arg == "--checkpoint" && hasValue) {
+            options.checkpoint = std::make_shared<const Checkpoint>(argv[++i]);
+        } else if (arg == "--software") {
+            options.software = true;
+        } else {
+            throw std::invalid_argument("Unknown or incomplete option " + arg);
+        }
+    }
+    // Loaded once the engine is known, each takes the pattern in its own form
+    if (!patternPath.empty() && options.gpu) {
+        options.runs = std::make_shared<const Pattern::Runs>(Pattern::loadRuns(patternPath));
+        if (!ruleSet && options.runs->rule) options.rule = *options.runs->rule;
+    } else if (!patternPath.empty()) {
+        options.pattern = std::make_shared<const Pattern>(Pattern::load(patternPath));
+        if (!ruleSet && options.pattern->getRule()) options.rule = *options.pattern->getRule();
+    }
+    if (options.checkpoint) {
+        const Checkpoint::Info& info = options.checkpoint->getInfo();
+        if (info.width != info.height) throw std::invalid_argument("Checkpoints of square grids only");
+        options.gridSize = info.width;
+        options.rule = info.rule;
+        options.boundary = info.boundary;
+        options.seed = info.seed;
+    }
+    return options;
+}
+
+static Result runGpu(const Options& options)
+{
+    Life::Config config;
+    config.gridSize = options.gridSize;
+    config.rule = options.rule;
+    config.boundary = options.boundary;
+    config.workgroupSize = options.workgroupSize;
+    config.seed = options.seed;
+    config.density = options.density;
+    config.checkpoint = options.checkpoint;
+    config.pattern = options.runs;
+    if (options.kernel == "bits") {
+        config.packing = Life::Packing::Bits;
+    } else if (!options.kernel.empty() && options.kernel != "u32") {
+        throw std::invalid_argument("The GPU engine has the u32 and bits kernels, got " + options.kernel);
+    }
+    // Nothing is drawn, the offscreen target only has to exist
+    config.headless = true;
+    config.frameWidth = 1;
+    config.frameHeight = 1;
+    config.historyBudget = 0;
+    config.forceFallbackAdapter = options.software;
+
+    Life life { config };
+    life.waitUntilReady();
+    life.simulate(options.warmup);
+
+    const auto start = std::chrono::steady_clock::now();
+    life.simulate(options.generations);
+    const auto end = std::chrono::steady_clock::now();
+
+    Result result;
+    const bool bits = config.packing == Life::Packing::Bits;
+    result.description = "gpu, " + std::string(bits ? "bits" : "u32") + " kernel, workgroup "
+        + std::to_string(life.getConfig().workgroupSize);
+    result.width = life.getConfig().gridSize;
+    result.height = life.getConfig().gridSize;
+    result.generation = life.getGeneration();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    const uint64_t cells = static_cast<uint64_t>(result.width) * result.height;
+    result.stateBytes = bits ? cells / 8 : cells * sizeof(uint32_t);
+    life.readCells(result.cells);
+    return result;
+}
+
+static Result runCpu(const Options& options)
+{
+    CpuLife::Config config;
+    config.width = options.gridSize;
+    config.height = options.gridSize;
+    config.rule = options.rule;
+    config.boundary = options.boundary;
+    config.threads = options.threads;
+    if (options.kernel == "swar32") {
+        config.kernel = CpuLife::Kernel::Swar32;
+    } else if (!options.kernel.empty() && options.kernel != "vector") {
+        throw std::invalid_argument("The CPU engine has the vector and swar32 kernels, got " + options.kernel);
+    }
+
+    CpuLife life { config };
+    if (options.checkpoint) {
+        life.restore(*options.checkpoint);
+    } else if (options.pattern) {
+        const uint32_t width = std::min(options.pattern->getWidth(), life.getWidth());
+        const uint32_t height = std::min(options.pattern->getHeight(), life.getHeight());
+        life.load(*options.pattern, (life.getWidth() - width) / 2, (life.getHeight() - height) / 2);
+    } else {
+        life.randomize(options.seed, options.density);
+    }
+    const auto advance = [&life](uint64_t generations) {
+        for (; generations > 0; generations -= std::min<uint64_t>(generations, UINT32_MAX)) {
+            life.step(static_cast<uint32_t>(std::min<uint64_t>(generations, UINT32_MAX)));
+        }
+    };
+    advance(options.warmup);
+
+    const auto start = std::chrono::steady_clock::now();
+    advance(options.generations);
+    const auto end = std::chrono::steady_clock::now();
+
+    Result result;
+    result.description = "cpu, " + std::string(config.kernel == CpuLife::Kernel::Swar32 ? "swar32" : "vector")
+        + " kernel, " + std::to_string(life.getThreadCount()) + " threads";
+    result.width = life.getWidth();
+    result.height = life.getHeight();
+    result.generation = life.getGeneration();
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.stateBytes = static_cast<uint64_t>(result.width) * result.height / 8;
+    result.cells.resize(static_cast<size_t>(result.width / 32) * result.height);
+    life.copyCells(result.cells.data());
+    return result;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        const Result result = options.gpu ? runGpu(options) : runCpu(options);
+
+        uint64_t population = 0;
+        for (uint32_t word : result.cells) population += std::popcount(word);
+        const double seconds = std::max(result.seconds, 1e-9);
+        const double generationsPerSecond = options.generations / seconds;
+        const double cells = static_cast<double>(result.width) * result.height;
+        char hash[17];
+        std::snprintf(hash, sizeof(hash), "%016llx",
+                      static_cast<unsigned long long>(hashCells(result.cells.data(), result.cells.size())));
+
+        std::cout << "engine: " << result.description << "\n"
+                  << "grid: " << result.width << "x" << result.height << " " << options.rule.toString()
+                  << (options.boundary == Boundary::Torus ? " torus" : " dead edges") << "\n"
+                  << "generations: " << options.generations << " in " << result.seconds << " s"
+                  << " (warm-up " << options.warmup << ", final generation " << result.generation << ")\n"
+                  << "generations/s: " << generationsPerSecond << "\n"
+                  << "cells/s: " << generationsPerSecond * cells << "\n"
+                  // Each generation reads and writes the whole state once, neighbors and halos are not counted
+                  << "effective GB/s: " << generationsPerSecond * 2.0 * result.stateBytes / 1e9 << "\n"
+                  << "population: " << population << "\n"
+                  << "hash: " << hash << std::endl;
+    } catch(const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,357 @@
+// Platform*.cpp use the wgpu wrappers, whose definitions live in the entry point
+#define WEBGPU_CPP_IMPLEMENTATION
+#include "webgpu.hpp"
+#include "CpuLife.h"
+#include "Life.h"
+#include "PerfCounters.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Stepping kernels of both engines over a matrix of grid sizes and soup densities. Every case runs
+// for at least --min-time seconds (generations double until it does) and reports cells/s, ns/cell
+// and bytes/cell moved. --json writes the results, --baseline compares against a file written that
+// way and exits with 2 when a case got slower than --threshold percent. On Linux, hardware counters
+// (PerfCounters) of the measured run are reported per cell and per generation next to the wall clock,
+// so a regression shows as a cache or a compute problem. GPU cases count the host side only. Native only
+// usage: life-bench [--kernels cpu-swar32,cpu-vector,cpu-threaded,gpu-u32,gpu-bits]
+//                   [--sizes 256,1024,...] [--densities 0.1,0.5] [--min-time S] [--threads N]
+//                   [--workgroup N] [--software] [--no-counters]
+//                   [--json FILE] [--baseline FILE [--threshold PCT]]
+struct Options {
+    std::vector<std::string> kernels { "cpu-swar32", "cpu-vector", "cpu-threaded", "gpu-u32", "gpu-bits" };
+    std::vector<uint32_t> sizes { 256, 1024, 4096, 16384, 65536 };
+    std::vector<float> densities { 0.1f, 0.5f };
+    double minSeconds = 0.5;
+    unsigned threads = std::thread::hardware_concurrency();
+    uint32_t workgroupSize = 8;
+    bool software = false;
+    bool counters = true;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 10.0;
+};
+
+struct Case {
+    std::string kernel;
+    uint32_t size = 0;
+    float density = 0.0f;
+    unsigned threads = 1;
+    std::string skipped; // Why the case didn't run, empty when it did
+    uint64_t generations = 0;
+    double seconds = 0.0;
+    double bytesPerCell = 0.0; // State read and written per cell and generation
+    PerfCounters::Sample counters;
+
+    std::string key() const
+    {
+        char text[96];
+        std::snprintf(text, sizeof(text), "%s %ux%u density %.2f", kernel.c_str(), size, size, density);
+        return text;
+    }
+    double cells() const { return static_cast<double>(size) * size * generations; }
+    double cellsPerSecond() const { return cells() / seconds; }
+    double nsPerCell() const { return 1e9 / cellsPerSecond(); }
+};
+
+template <typename T>
+static std::vector<T> parseList(const std::string& text, const std::function<T(const std::string&)>& parse)
+{
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) if (!item.empty()) values.push_back(parse(item));
+    if (values.empty()) throw std::invalid_argument("Empty list " + text);
+    return values;
+}
+
+static Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--kernels" && hasValue) {
+            options.kernels = parseList<std::string>(argv[++i], [](const std::string& item) { return item; });
+        } else if (arg == "--sizes" && hasValue) {
+            options.sizes = parseList<uint32_t>(argv[++i], [](const std::string& item) {
+                return static_cast<uint32_t>(std::stoul(item));
+            });
+        } else if (arg == "--densities" && hasValue) {
+            options.densities = parseList<float>(argv[++i], [](const std::string& item) { return std::stof(item); });
+        } else if (arg == "--min-time" && hasValue) {
+            options.minSeconds = std::stod(argv[++i]);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--workgroup" && hasValue) {
+            options.workgroupSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--software") {
+            options.software = true;
+        } else if (arg == "--no-counters") {
+            options.counters = false;
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            options.threshold = std::stod(argv[++i]);
+        } else {
+            throw std::invalid_argument("Unknown or incomplete option " + arg);
+        }
+    }
+    return options;
+}
+
+// Doubles the generation count from one until a run takes minSeconds, the last run is the result.
+// Every run starts over from the soup (reseed), so it doesn't time a grid the earlier runs have thinned out
+static void measure(Case& result, double minSeconds, PerfCounters* counters,
+                    const std::function<void()>& reseed, const std::function<void(uint64_t)>& advance)
+{
+    for (uint64_t generations = 1;; generations *= 2) {
+        reseed();
+        if (counters) counters->start();
+        const auto start = std::chrono::steady_clock::now();
+        advance(generations);
+        const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (counters) result.counters = counters->stop();
+        if (seconds >= minSeconds || generations >= (1ull << 40)) {
+            result.generations = generations;
+            result.seconds = std::max(seconds, 1e-9);
+            return;
+        }
+    }
+}
+
+static void runCpu(Case& result, const Options& options, CpuLife::Kernel kernel, unsigned threads)
+{
+    CpuLife::Config config;
+    config.width = result.size;
+    config.height = result.size;
+    config.threads = threads;
+    config.kernel = kernel;
+    // Before the engine, so its worker threads inherit the counters
+    std::unique_ptr<PerfCounters> counters = options.counters ? std::make_unique<PerfCounters>() : nullptr;
+    CpuLife life { config };
+    result.threads = life.getThreadCount();
+    result.bytesPerCell = 2.0 / 8.0;
+    const auto reseed = [&life, &result]() { life.randomize(1, result.density); };
+    measure(result, options.minSeconds, counters.get(), reseed, [&life](uint64_t generations) {
+        for (; generations > 0; generations -= std::min<uint64_t>(generations, UINT32_MAX)) {
+            life.step(static_cast<uint32_t>(std::min<uint64_t>(generations, UINT32_MAX)));
+        }
+    });
+}
+
+static void runGpu(Case& result, const Options& options, Life::Packing packing)
+{
+    Life::Config config;
+    config.gridSize = result.size;
+    config.packing = packing;
+    config.workgroupSize = options.workgroupSize;
+    config.seed = 1;
+    config.density = result.density;
+    config.headless = true;
+    config.frameWidth = 1;
+    config.frameHeight = 1;
+    config.historyBudget = 0;
+    config.forceFallbackAdapter = options.software;
+    std::unique_ptr<PerfCounters> counters = options.counters ? std::make_unique<PerfCounters>() : nullptr;
+    Life life { config };
+    life.waitUntilReady();
+    result.threads = 0;
+    result.bytesPerCell = packing == Life::Packing::Bits ? 2.0 / 8.0 : 2.0 * sizeof(uint32_t);
+    // First dispatches pay for pipeline and driver warm-up
+    life.simulate(4);
+    // The seeding pass is queued ahead of the timed steps, it costs about as much as one generation
+    const auto reseed = [&life, &config]() { life.seed(config.seed, config.density); };
+    measure(result, options.minSeconds, counters.get(), reseed, [&life](uint64_t generations) { life.simulate(generations); });
+}
+
+static void runCase(Case& result, const Options& options)
+{
+    try {
+        if (result.kernel == "cpu-swar32") {
+            runCpu(result, options, CpuLife::Kernel::Swar32, 1);
+        } else if (result.kernel == "cpu-vector") {
+            runCpu(result, options, CpuLife::Kernel::Vector, 1);
+        } else if (result.kernel == "cpu-threaded") {
+            runCpu(result, options, CpuLife::Kernel::Vector, options.threads);
+        } else if (result.kernel == "gpu-u32") {
+            runGpu(result, options, Life::Packing::U32);
+        } else if (result.kernel == "gpu-bits") {
+            runGpu(result, options, Life::Packing::Bits);
+        } else {
+            throw std::invalid_argument("Unknown kernel " + result.kernel);
+        }
+    } catch (const std::invalid_argument&) {
+        throw;
+    } catch (const std::exception& e) {
+        // Grids beyond the device limits or host memory are reported, the rest of the matrix still runs
+        result.skipped = e.what();
+    }
+}
+
+static std::string escapeJson(const std::string& text)
+{
+    std::string escaped;
+    for (char c : text) {
+        if (c == '"' || c == '\\') escaped += '\\';
+        if (static_cast<unsigned char>(c) >= 0x20) escaped += c;
+    }
+    return escaped;
+}
+
+// One case per line, so baselines are read back without a JSON parser (see readBaseline)
+static void writeJson(const std::string& path, const std::vector<Case>& cases, const Options& options)
+{
+    std::ofstream file(path);
+    file << "{\n  \"adapter\": \"" << (options.software ? "software" : "default") << "\",\n"
+         << "  \"workgroup\": " << options.workgroupSize << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < cases.size(); ++i) {
+        const Case& c = cases[i];
+        char field[256];
+        std::snprintf(field, sizeof(field), "    {\"kernel\": \"%s\", \"size\": %u, \"density\": %.4f",
+                      c.kernel.c_str(), c.size, c.density);
+        std::string line = field;
+        if (!c.skipped.empty()) {
+            line += ", \"skipped\": \"" + escapeJson(c.skipped) + "\"";
+        } else {
+            std::snprintf(field, sizeof(field),
+                          ", \"threads\": %u, \"generations\": %llu, \"seconds\": %.6f, \"cells_per_second\": %.6e, "
+                          "\"ns_per_cell\": %.6f, \"bytes_per_cell\": %.4f",
+                          c.threads, static_cast<unsigned long long>(c.generations), c.seconds, c.cellsPerSecond(),
+                          c.nsPerCell(), c.bytesPerCell);
+            line += field;
+            for (int index = 0; index < PerfCounters::COUNTER_COUNT; ++index) {
+                const auto counter = static_cast<PerfCounters::Counter>(index);
+                if (!c.counters.has(counter)) continue;
+                const char* name = PerfCounters::getName(counter);
+                std::snprintf(field, sizeof(field), ", \"%s_per_cell\": %.6e, \"%s_per_generation\": %.6e",
+                              name, c.counters.get(counter) / c.cells(), name, c.counters.get(counter) / c.generations);
+                line += field;
+            }
+            if (c.counters.ipc() > 0) {
+                std::snprintf(field, sizeof(field), ", \"ipc\": %.4f", c.counters.ipc());
+                line += field;
+            }
+        }
+        file << line << "}" << (i + 1 < cases.size() ? ",\n" : "\n");
+    }
+    file << "  ]\n}\n";
+    if (!file) throw std::runtime_error("Failed to write " + path);
+}
+
+static std::string jsonField(const std::string& line, const std::string& name)
+{
+    const std::string key = "\"" + name + "\": ";
+    const size_t start = line.find(key);
+    if (start == std::string::npos) return {};
+    size_t begin = start + key.size();
+    if (line[begin] == '"') {
+        const size_t end = line.find('"', begin + 1);
+        return line.substr(begin + 1, end - begin - 1);
+    }
+    const size_t end = line.find_first_of(",}", begin);
+    return line.substr(begin, end - begin);
+}
+
+// ns/cell of every case that ran, by Case::key()
+static std::map<std::string, double> readBaseline(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Failed to open baseline " + path);
+    std::map<std::string, double> baseline;
+    std::string line;
+    while (std::getline(file, line)) {
+        const std::string nsPerCell = jsonField(line, "ns_per_cell");
+        if (nsPerCell.empty()) continue;
+        Case c;
+        c.kernel = jsonField(line, "kernel");
+        c.size = static_cast<uint32_t>(std::stoul(jsonField(line, "size")));
+        c.density = std::stof(jsonField(line, "density"));
+        baseline[c.key()] = std::stod(nsPerCell);
+    }
+    return baseline;
+}
+
+int main(int argc, char** argv) {
+    try {
+        Options options = parseOptions(argc, argv);
+        if (options.counters) {
+            const PerfCounters probe;
+            if (!probe.isAvailable()) {
+                std::cerr << "Hardware counters unavailable (" << probe.getError() << "), wall clock only" << std::endl;
+                options.counters = false;
+            } else if (!probe.getError().empty()) {
+                std::cerr << "Some hardware counters unavailable (" << probe.getError() << ")" << std::endl;
+            }
+        }
+        const std::map<std::string, double> baseline = options.baselinePath.empty()
+            ? std::map<std::string, double> {} : readBaseline(options.baselinePath);
+
+        std::vector<Case> cases;
+        bool regressed = false;
+        for (const std::string& kernel : options.kernels) {
+            for (uint32_t size : options.sizes) {
+                for (float density : options.densities) {
+                    Case c;
+                    c.kernel = kernel;
+                    c.size = size;
+                    c.density = density;
+                    runCase(c, options);
+
+                    char line[256];
+                    if (!c.skipped.empty()) {
+                        std::snprintf(line, sizeof(line), "%-40s skipped: %s", c.key().c_str(), c.skipped.c_str());
+                    } else {
+                        std::snprintf(line, sizeof(line), "%-40s %10.3e cells/s %9.4f ns/cell %6.3f B/cell",
+                                      c.key().c_str(), c.cellsPerSecond(), c.nsPerCell(), c.bytesPerCell);
+                    }
+                    std::cout << line;
+                    const auto reference = baseline.find(c.key());
+                    if (c.skipped.empty() && reference != baseline.end()) {
+                        const double change = (c.nsPerCell() / reference->second - 1.0) * 100.0;
+                        const bool slower = change > options.threshold;
+                        regressed |= slower;
+                        std::snprintf(line, sizeof(line), "  %+6.1f%% vs baseline%s", change, slower ? "  REGRESSION" : "");
+                        std::cout << line;
+                    }
+                    std::cout << std::endl;
+                    if (c.skipped.empty() && c.counters.any()) {
+                        // Per cell, except the LLC misses, which are easier to compare per generation
+                        const auto perCell = [&c](PerfCounters::Counter counter) {
+                            return c.counters.has(counter) ? c.counters.get(counter) / c.cells() : 0.0;
+                        };
+                        std::snprintf(line, sizeof(line),
+                                      "%-40s IPC %5.2f  %.3f cycles %.3f instr %.2e L1D miss %.2e branch miss /cell  %.3e LLC miss/gen",
+                                      "", c.counters.ipc(), perCell(PerfCounters::Cycles), perCell(PerfCounters::Instructions),
+                                      perCell(PerfCounters::L1DMisses), perCell(PerfCounters::BranchMisses),
+                                      c.counters.has(PerfCounters::LlcMisses) ? c.counters.get(PerfCounters::LlcMisses) / c.generations : 0.0);
+                        std::cout << line << std::endl;
+                    }
+                    cases.push_back(std::move(c));
+                }
+            }
+        }
+
+        if (!options.jsonPath.empty()) writeJson(options.jsonPath, cases, options);
+        if (regressed) {
+            std::cerr << "Slower than the baseline by more than " << options.threshold << "%" << std::endl;
+            return 2;
+        }
+    } catch(const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,199 @@
+// Platform*.cpp use the wgpu wrappers, whose definitions live in main.cpp for the WebGPU targets
+#define WEBGPU_CPP_IMPLEMENTATION
+#include "webgpu.hpp"
+#include "CpuLife.h"
+#include "FrameExporter.h"
+#include "Platform.h"
+#include "Recorder.h"
+#include <algorithm>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+
+// Entry point of the CPU engine: the browser fallback when WebGPU is missing (fallback.js, or
+// fallback-single.js on pages that aren't cross-origin isolated, loaded by index.html) and the native
+// life-cpu binary
+// usage: life-cpu [--frames N] [--size WxH] [--export DIR|FILE.y4m] [--threads N]
+//                 [--rule B3/S23] [--dead-edges] [--seed N] [--density F]
+//                 [--pattern FILE.rle|.cells|.lif] [--checkpoint FILE]
+//                 [--save-checkpoint FILE [--checkpoint-every N]]
+//                 [--record FILE [--keyframe-every N]] [--replay FILE [--from G]]
+struct Options {
+    CpuLife::Config config;
+    uint64_t frameCount = 0; // 0 runs until the page is closed
+    std::string exportPath;
+    uint64_t seed = std::random_device{}();
+    float density = 0.5f;
+    std::unique_ptr<Pattern> pattern; // Centered instead of the soup
+    std::unique_ptr<Checkpoint> checkpoint; // Resumed instead of either, with its size, rule and boundary
+    std::string checkpointPath; // Saved after the last frame, and every checkpointInterval frames if set
+    uint64_t checkpointInterval = 0;
+    std::string recordPath; // Every generation from the first one on
+    uint32_t keyframeInterval = 256;
+    std::unique_ptr<Recording> replay; // Played back instead of simulated, from replayFrom on
+    uint64_t replayFrom = UINT64_MAX;
+};
+
+static Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    if (!Platform::hasSurface()) options.frameCount = 1000;
+    bool ruleSet = false; // An explicit --rule wins over the one in a pattern file
+
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--frames" && hasValue) {
+            options.frameCount = std::stoull(argv[++i]);
+        } else if (arg == "--size" && hasValue) {
+            const std::string size = argv[++i];
+            const size_t separator = size.find('x');
+            if (separator == std::string::npos) throw std::invalid_argument("--size expects WxH, got " + size);
+            options.config.width = static_cast<uint32_t>(std::stoul(size.substr(0, separator)));
+            options.config.height = static_cast<uint32_t>(std::stoul(size.substr(separator + 1)));
+        } else if (arg == "--export" && hasValue) {
+            options.exportPath = argv[++i];
+        } else if (arg == "--threads" && hasValue) {
+            options.config.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--rule" && hasValue) {
+            options.config.rule = Rule::parse(argv[++i]);
+            ruleSet = true;
+        } else if (arg == "--dead-edges") {
+            options.config.boundary = Boundary::Dead;
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--density" && hasValue) {
+            options.density = std::stof(argv[++i]);
+        } else if (arg == "--pattern" && hasValue) {
+            options.pattern = std::make_unique<Pattern>(Pattern::load(argv[++i]));
+            if (!ruleSet && options.pattern->getRule()) options.config.rule = *options.pattern->getRule();
+        } else if (arg == "--checkpoint" && hasValue) {
+            options.checkpoint = std::make_unique<Checkpoint>(argv[++i]);
+        } else if (arg == "--save-checkpoint" && hasValue) {
+            options.checkpointPath = argv[++i];
+        } else if (arg == "--checkpoint-every" && hasValue) {
+            options.checkpointInterval = std::stoull(argv[++i]);
+        } else if (arg == "--record" && hasValue) {
+            options.recordPath = argv[++i];
+        } else if (arg == "--keyframe-every" && hasValue) {
+            options.keyframeInterval = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--replay" && hasValue) {
+            options.replay = std::make_unique<Recording>(argv[++i]);
+        } else if (arg == "--from" && hasValue) {
+            options.replayFrom = std::stoull(argv[++i]);
+        } else {
+            throw std::invalid_argument("Unknown or incomplete option " + arg);
+        }
+    }
+    if (options.checkpoint) {
+        const Checkpoint::Info& info = options.checkpoint->getInfo();
+        options.config.width = info.width;
+        options.config.height = info.height;
+        options.config.rule = info.rule;
+        options.config.boundary = info.boundary;
+        options.seed = info.seed;
+    }
+    if (options.replay) {
+        options.config.width = options.replay->getWidth();
+        options.config.height = options.replay->getHeight();
+        options.config.rule = options.replay->getRule();
+        options.config.boundary = options.replay->getBoundary();
+        if (options.replayFrom == UINT64_MAX) options.replayFrom = options.replay->getFirstGeneration();
+    }
+    return options;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        CpuLife life { options.config };
+        if (options.replay) {
+            life.setCells(options.replay->seek(options.replayFrom).data(), options.replayFrom);
+        } else if (options.checkpoint) {
+            life.restore(*options.checkpoint);
+        } else if (options.pattern) {
+            const uint32_t width = std::min(options.pattern->getWidth(), life.getWidth());
+            const uint32_t height = std::min(options.pattern->getHeight(), life.getHeight());
+            life.load(*options.pattern, (life.getWidth() - width) / 2, (life.getHeight() - height) / 2);
+        } else {
+            life.randomize(options.seed, options.density);
+        }
+        std::cout << "CPU engine: " << life.getWidth() << "x" << life.getHeight()
+                  << " on " << life.getThreadCount() << " threads" << std::endl;
+
+        std::unique_ptr<FrameExporter> exporter;
+        if (!options.exportPath.empty()) {
+            const bool y4m = options.exportPath.size() > 4
+                && options.exportPath.compare(options.exportPath.size() - 4, 4, ".y4m") == 0;
+            exporter = std::make_unique<FrameExporter>(
+                y4m ? FrameExporter::Format::Y4m : FrameExporter::Format::Png,
+                options.exportPath
+            );
+        }
+
+        std::unique_ptr<Recorder> recorder;
+        const size_t gridWords = static_cast<size_t>(life.getWidth() / 32) * life.getHeight();
+        const auto record = [&]() {
+            std::vector<uint32_t> grid(gridWords);
+            life.copyCells(grid.data());
+            recorder->submit(life.getGeneration(), std::move(grid));
+        };
+        if (!options.recordPath.empty()) {
+            Recorder::Config recorderConfig;
+            recorderConfig.width = life.getWidth();
+            recorderConfig.height = life.getHeight();
+            recorderConfig.rule = options.config.rule;
+            recorderConfig.boundary = options.config.boundary;
+            recorderConfig.firstGeneration = life.getGeneration();
+            recorderConfig.keyframeInterval = options.keyframeInterval;
+            recorder = std::make_unique<Recorder>(options.recordPath, recorderConfig);
+            record();
+        }
+
+        // One generation per frame, the browser calls this once per animation frame
+        uint64_t frame = 0;
+        bool failed = false;
+        std::vector<uint8_t> pixels;
+        const std::function<bool()> renderLoop = [&]() {
+            try {
+                if (options.replay) {
+                    const uint64_t generation = life.getGeneration() + 1;
+                    Recording& recording = *options.replay;
+                    if (generation - recording.getFirstGeneration() >= recording.getFrameCount()) return false;
+                    life.setCells(recording.seek(generation).data(), generation);
+                } else {
+                    life.step();
+                }
+                if (recorder) record();
+                if (exporter || Platform::hasSurface()) life.render(pixels);
+                Platform::presentPixels(pixels.data(), life.getWidth(), life.getHeight());
+                if (exporter) exporter->submit({ frame, life.getWidth(), life.getHeight(), pixels });
+                if (!options.checkpointPath.empty() && options.checkpointInterval > 0
+                    && (frame + 1) % options.checkpointInterval == 0) {
+                    life.save(options.checkpointPath, options.seed);
+                }
+            } catch (const std::exception& e) {
+                std::cerr << "Fatal error: " << e.what() << std::endl;
+                failed = true;
+                return false;
+            }
+            return options.frameCount == 0 || ++frame < options.frameCount;
+        };
+        Platform::runLoop(renderLoop);
+
+        // Only reached natively, the browser loop never returns
+        if (failed) return 1;
+        if (exporter) exporter->finish();
+        if (recorder) recorder->finish();
+        if (!options.checkpointPath.empty()) life.save(options.checkpointPath, options.seed);
+        std::cout << "Population after " << life.getGeneration() << " generations: "
+                  << life.getPopulation() << std::endl;
+    } catch(const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,333 @@
+// Platform*.cpp use the wgpu wrappers, whose definitions live in the entry point
+#define WEBGPU_CPP_IMPLEMENTATION
+#include "webgpu.hpp"
+#include "CpuLife.h"
+#include "Life.h"
+#include "Pattern.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifndef GOLDEN_FILE
+#define GOLDEN_FILE "golden/hashes.txt"
+#endif
+
+// Golden state regression suite: fixed patterns and seeded soups run for fixed generation counts on
+// every engine, and the final hashCells, population and trajectory (the hashes of every generation
+// folded together, catching runs that only meet again at the end) are compared against the golden
+// file. Soups are seeded by each engine itself and patterns go through its own loader, so seeding and
+// the GPU run-length decoder are covered too. --final-only skips the per-generation readbacks, which
+// is what dominates on the GPU. --update rewrites the golden file once every engine agrees. Native only
+// usage: life-golden [--engines cpu-swar32,cpu-vector,cpu-threaded,gpu-u32,gpu-bits] [--cases NAME,...]
+//                    [--golden FILE] [--final-only] [--update] [--threads N] [--workgroup N] [--software]
+struct Options {
+    std::vector<std::string> engines { "cpu-swar32", "cpu-vector", "cpu-threaded", "gpu-u32", "gpu-bits" };
+    std::vector<std::string> cases; // All when empty
+    std::string goldenPath = GOLDEN_FILE;
+    bool trajectory = true;
+    bool update = false;
+    unsigned threads = std::thread::hardware_concurrency();
+    uint32_t workgroupSize = 8;
+    bool software = false;
+};
+
+struct Case {
+    std::string name;
+    uint32_t size;
+    Rule rule;
+    Boundary boundary;
+    uint64_t generations;
+    const char* rle;  // Centered on an empty grid, a soup when null
+    uint64_t seed;
+    float density;
+};
+
+struct State {
+    uint64_t hash = 0;
+    uint64_t trajectory = 0; // 0 when not traced
+    uint64_t population = 0;
+    bool operator==(const State& other) const = default;
+};
+
+static const char* R_PENTOMINO = "x = 3, y = 3\nb2o$2o$bo!\n";
+static const char* ACORN = "x = 7, y = 3\nbo5b$3bo3b$2o2b3o!\n";
+static const char* GOSPER_GUN =
+    "x = 36, y = 9\n"
+    "24bo11b$22bobo11b$12b2o6b2o12b2o$11bo3bo4b2o12b2o$2o8bo5bo3b2o14b$2o8bo3bob2o4bobo11b$"
+    "10bo5bo7bo11b$11bo3bo20b$12b2o22b!\n";
+
+static const std::vector<Case>& getCases()
+{
+    const Rule conway = Rule::parse("B3/S23");
+    const Rule highLife = Rule::parse("B36/S23");
+    static const std::vector<Case> cases {
+        { "rpentomino-256-torus", 256, conway, Boundary::Torus, 1200, R_PENTOMINO, 0, 0.0f },
+        { "rpentomino-1024-dead", 1024, conway, Boundary::Dead, 1200, R_PENTOMINO, 0, 0.0f },
+        { "acorn-256-dead", 256, conway, Boundary::Dead, 2000, ACORN, 0, 0.0f },
+        { "acorn-1024-torus", 1024, conway, Boundary::Torus, 5300, ACORN, 0, 0.0f },
+        { "gosper-gun-256-torus", 256, conway, Boundary::Torus, 1000, GOSPER_GUN, 0, 0.0f },
+        { "gosper-gun-1024-dead", 1024, conway, Boundary::Dead, 1000, GOSPER_GUN, 0, 0.0f },
+        { "soup-96-torus", 96, conway, Boundary::Torus, 500, nullptr, 7, 0.5f },
+        { "soup-1024-torus-seed1", 1024, conway, Boundary::Torus, 1000, nullptr, 1, 0.5f },
+        { "soup-1024-dead-seed2", 1024, conway, Boundary::Dead, 1000, nullptr, 2, 0.5f },
+        { "soup-1024-torus-sparse", 1024, conway, Boundary::Torus, 1000, nullptr, 3, 0.2f },
+        { "soup-1024-highlife", 1024, highLife, Boundary::Torus, 500, nullptr, 4, 0.5f },
+    };
+    return cases;
+}
+
+// Steps an engine and reads its grid back bitpacked, like CpuLife::copyCells and Life::readCells
+struct Engine {
+    std::function<void(uint64_t)> step;
+    std::function<void(std::vector<uint32_t>&)> readCells;
+    std::shared_ptr<void> owner;
+};
+
+static Engine createEngine(const Options& options, const std::string& name, const Case& c)
+{
+    Engine engine;
+    if (name.starts_with("gpu")) {
+        Life::Config config;
+        config.gridSize = c.size;
+        config.rule = c.rule;
+        config.boundary = c.boundary;
+        config.packing = name == "gpu-bits" ? Life::Packing::Bits : Life::Packing::U32;
+        config.workgroupSize = options.workgroupSize;
+        config.seed = c.rle ? 1 : c.seed;
+        config.density = c.density;
+        if (c.rle) config.pattern = std::make_shared<const Pattern::Runs>(Pattern::readRuns(c.rle));
+        config.headless = true;
+        config.frameWidth = 1;
+        config.frameHeight = 1;
+        config.historyBudget = 0;
+        config.forceFallbackAdapter = options.software;
+        auto life = std::make_shared<Life>(config);
+        life->waitUntilReady();
+        engine.step = [gpu = life.get()](uint64_t generations) { gpu->simulate(generations); };
+        engine.readCells = [gpu = life.get()](std::vector<uint32_t>& words) { gpu->readCells(words); };
+        engine.owner = life;
+        return engine;
+    }
+
+    CpuLife::Config config;
+    config.width = c.size;
+    config.height = c.size;
+    config.rule = c.rule;
+    config.boundary = c.boundary;
+    config.threads = name == "cpu-threaded" ? options.threads : 1;
+    config.kernel = name == "cpu-swar32" ? CpuLife::Kernel::Swar32 : CpuLife::Kernel::Vector;
+    auto life = std::make_shared<CpuLife>(config);
+    if (c.rle) {
+        const Pattern pattern = Pattern::parse(c.rle, Pattern::Format::Rle);
+        const uint32_t width = std::min(pattern.getWidth(), life->getWidth());
+        const uint32_t height = std::min(pattern.getHeight(), life->getHeight());
+        life->load(pattern, (life->getWidth() - width) / 2, (life->getHeight() - height) / 2);
+    } else {
+        life->randomize(c.seed, c.density);
+    }
+    engine.step = [cpu = life.get()](uint64_t generations) {
+        for (; generations > 0; generations -= std::min<uint64_t>(generations, UINT32_MAX)) {
+            cpu->step(static_cast<uint32_t>(std::min<uint64_t>(generations, UINT32_MAX)));
+        }
+    };
+    engine.readCells = [cpu = life.get()](std::vector<uint32_t>& words) {
+        words.resize(static_cast<size_t>(cpu->getWidth() / 32) * cpu->getHeight());
+        cpu->copyCells(words.data());
+    };
+    engine.owner = life;
+    return engine;
+}
+
+static State run(const Options& options, const std::string& name, const Case& c)
+{
+    Engine engine = createEngine(options, name, c);
+    std::vector<uint32_t> words;
+    State state;
+    if (options.trajectory) {
+        // FNV-1a over the per-generation hashes, generation 0 included
+        state.trajectory = 0xcbf29ce484222325ull;
+        for (uint64_t generation = 0;; ++generation) {
+            engine.readCells(words);
+            state.trajectory = (state.trajectory ^ hashCells(words.data(), words.size())) * 0x100000001b3ull;
+            if (generation == c.generations) break;
+            engine.step(1);
+        }
+    } else {
+        engine.step(c.generations);
+        engine.readCells(words);
+    }
+    state.hash = hashCells(words.data(), words.size());
+    for (uint32_t word : words) state.population += std::popcount(word);
+    return state;
+}
+
+static std::string formatState(const State& state)
+{
+    char text[64];
+    std::snprintf(text, sizeof(text), "%016llx %016llx %llu", static_cast<unsigned long long>(state.hash),
+                  static_cast<unsigned long long>(state.trajectory), static_cast<unsigned long long>(state.population));
+    return text;
+}
+
+// Golden states by case name, with the generation count they were recorded at
+static std::map<std::string, std::pair<uint64_t, State>> readGolden(const std::string& path)
+{
+    std::ifstream file(path);
+    if (!file) throw std::runtime_error("Failed to open golden file " + path);
+    std::map<std::string, std::pair<uint64_t, State>> golden;
+    std::string line;
+    while (std::getline(file, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        std::istringstream fields(line);
+        std::string name;
+        uint64_t generations = 0;
+        State state;
+        fields >> name >> generations >> std::hex >> state.hash >> state.trajectory >> std::dec >> state.population;
+        if (!fields) throw std::runtime_error("Malformed golden line: " + line);
+        golden[name] = { generations, state };
+    }
+    return golden;
+}
+
+static void writeGolden(const std::string& path, const std::vector<std::pair<const Case*, State>>& states)
+{
+    std::ofstream file(path);
+    file << "# Golden states of life-golden: case, generations, hashCells of the last generation, trajectory\n"
+         << "# (per-generation hashes folded together) and population. Regenerate with life-golden --update\n"
+         << "# only after an intended change of the rules, the cases or the hash\n";
+    for (const auto& [c, state] : states) file << c->name << " " << c->generations << " " << formatState(state) << "\n";
+    if (!file) throw std::runtime_error("Failed to write " + path);
+}
+
+template <typename T>
+static std::vector<T> parseList(const std::string& text, const std::function<T(const std::string&)>& parse)
+{
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) if (!item.empty()) values.push_back(parse(item));
+    if (values.empty()) throw std::invalid_argument("Empty list " + text);
+    return values;
+}
+
+static Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--engines" && hasValue) {
+            options.engines = parseList<std::string>(argv[++i], [](const std::string& item) { return item; });
+        } else if (arg == "--cases" && hasValue) {
+            options.cases = parseList<std::string>(argv[++i], [](const std::string& item) { return item; });
+        } else if (arg == "--golden" && hasValue) {
+            options.goldenPath = argv[++i];
+        } else if (arg == "--final-only") {
+            options.trajectory = false;
+        } else if (arg == "--update") {
+            options.update = true;
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--workgroup" && hasValue) {
+            options.workgroupSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--software") {
+            options.software = true;
+        } else {
+            throw std::invalid_argument("Unknown or incomplete option " + arg);
+        }
+    }
+    for (const std::string& name : options.engines) {
+        if (name != "cpu-swar32" && name != "cpu-vector" && name != "cpu-threaded" && name != "gpu-u32" && name != "gpu-bits") {
+            throw std::invalid_argument("Unknown engine " + name);
+        }
+    }
+    if (options.update && !options.trajectory) throw std::invalid_argument("--update records trajectories, drop --final-only");
+    return options;
+}
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        std::vector<const Case*> cases;
+        for (const Case& c : getCases()) {
+            if (options.cases.empty() || std::find(options.cases.begin(), options.cases.end(), c.name) != options.cases.end()) {
+                cases.push_back(&c);
+            }
+        }
+        if (cases.empty()) throw std::invalid_argument("No case matches --cases");
+        if (options.update && cases.size() != getCases().size()) throw std::invalid_argument("--update records every case");
+        const auto golden = options.update ? std::map<std::string, std::pair<uint64_t, State>> {} : readGolden(options.goldenPath);
+
+        uint64_t failures = 0;
+        std::vector<std::pair<const Case*, State>> recorded;
+        for (const Case* c : cases) {
+            const auto expected = golden.find(c->name);
+            if (!options.update && (expected == golden.end() || expected->second.first != c->generations)) {
+                std::cout << "FAIL " << c->name << ": no golden state for " << c->generations << " generations" << std::endl;
+                ++failures;
+                continue;
+            }
+
+            std::optional<State> agreed;
+            bool agree = true;
+            for (const std::string& name : options.engines) {
+                State state;
+                try {
+                    state = run(options, name, *c);
+                } catch (const std::exception& e) {
+                    std::cout << "FAIL " << name << " " << c->name << ": " << e.what() << std::endl;
+                    ++failures;
+                    agree = false;
+                    continue;
+                }
+
+                if (options.update) {
+                    if (agreed && !(*agreed == state)) agree = false;
+                    if (!agreed) agreed = state;
+                    std::cout << (agree ? "     " : "DIFF ") << name << " " << c->name << ": " << formatState(state) << std::endl;
+                    continue;
+                }
+                State want = expected->second.second;
+                if (!options.trajectory) want.trajectory = 0;
+                if (state == want) {
+                    std::cout << "ok   " << name << " " << c->name << std::endl;
+                } else {
+                    std::cout << "FAIL " << name << " " << c->name << ": got " << formatState(state)
+                              << ", expected " << formatState(want) << std::endl;
+                    ++failures;
+                }
+            }
+            if (options.update) {
+                if (!agree || !agreed) throw std::runtime_error("Engines disagree on " + c->name + ", golden file left as it is");
+                recorded.emplace_back(c, *agreed);
+            }
+        }
+
+        if (options.update) {
+            writeGolden(options.goldenPath, recorded);
+            std::cout << "Recorded " << recorded.size() << " golden states in " << options.goldenPath << std::endl;
+            return 0;
+        }
+        if (failures > 0) {
+            std::cout << failures << " failures" << std::endl;
+            return 1;
+        }
+        std::cout << "Every engine matches the golden states" << std::endl;
+    } catch(const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
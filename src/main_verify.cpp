@@ -0,0 +1,373 @@
+// Platform*.cpp use the wgpu wrappers, whose definitions live in the entry point
+#define WEBGPU_CPP_IMPLEMENTATION
+#include "webgpu.hpp"
+#include "CpuLife.h"
+#include "Life.h"
+#include "Simulation.h"
+#include <algorithm>
+#include <bit>
+#include <cstdio>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Differential verification of every stepping kernel against a reference: the rule of the one cell
+// per u32 computeMain in shader.wgsl, transcribed cell by cell with cellIndex's wrapping. Each engine
+// starts from the same grid (soups at adversarial densities, patterns straddling the edges and word
+// seams, stripes) and is compared after every --check-every generations. The first diverging
+// generation and cell is reported, and the exit code is 1 if any kernel diverged. Native only
+// usage: life-verify [--engines cpu-swar32,cpu-vector,cpu-threaded,gpu-u32,gpu-bits]
+//                    [--sizes 64,96,256] [--rules B3/S23,B36/S23,B2/S] [--generations N]
+//                    [--check-every N] [--threads N] [--workgroup N] [--seed N] [--software]
+struct Options {
+    std::vector<std::string> engines { "cpu-swar32", "cpu-vector", "cpu-threaded", "gpu-u32", "gpu-bits" };
+    std::vector<uint32_t> sizes { 64, 96, 256 }; // Multiples of 32, square like the GPU engine
+    std::vector<Rule> rules { Rule::parse("B3/S23"), Rule::parse("B36/S23"), Rule::parse("B2/S") };
+    uint64_t generations = 2000;
+    uint32_t checkInterval = 1;
+    unsigned threads = 4; // Several bands even on small grids, so band seams are covered
+    uint32_t workgroupSize = 8;
+    uint64_t seed = 1;
+    bool software = false;
+};
+
+// One cell per byte, stepped the way computeMain does for one cell per u32
+class ReferenceLife
+{
+public:
+    ReferenceLife(uint32_t size, Rule rule, Boundary boundary)
+        : size(size), rule(rule), boundary(boundary), cells(static_cast<size_t>(size) * size) {}
+
+    // cellIndex: coordinates wrap around the grid, beyond the edges is inactive without the torus
+    uint32_t cellActive(int64_t x, int64_t y) const
+    {
+        const int64_t n = size;
+        if (boundary == Boundary::Dead && (x < 0 || y < 0 || x >= n || y >= n)) return 0;
+        // Neighbors are at most one cell beyond an edge, so one wrap is the modulo
+        x = x < 0 ? x + n : x >= n ? x - n : x;
+        y = y < 0 ? y + n : y >= n ? y - n : y;
+        return cells[static_cast<size_t>(y * n + x)];
+    }
+
+    void step()
+    {
+        std::vector<uint8_t> next(cells.size());
+        for (int64_t y = 0; y < size; ++y) {
+            for (int64_t x = 0; x < size; ++x) {
+                const uint32_t activeNeighbors = cellActive(x + 1, y + 1) + cellActive(x + 1, y) + cellActive(x + 1, y - 1)
+                    + cellActive(x, y - 1) + cellActive(x - 1, y - 1) + cellActive(x - 1, y)
+                    + cellActive(x - 1, y + 1) + cellActive(x, y + 1);
+                const uint32_t mask = cellActive(x, y) == 1 ? rule.survival : rule.birth;
+                next[static_cast<size_t>(y * size + x)] = (mask >> activeNeighbors) & 1u;
+            }
+        }
+        cells.swap(next);
+    }
+
+    void setCells(const std::vector<uint32_t>& words)
+    {
+        const uint32_t wordsPerRow = size / 32;
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) cells[static_cast<size_t>(y) * size + x] = (words[y * wordsPerRow + x / 32] >> (x % 32)) & 1u;
+        }
+    }
+
+    void copyCells(std::vector<uint32_t>& words) const
+    {
+        const uint32_t wordsPerRow = size / 32;
+        words.assign(static_cast<size_t>(wordsPerRow) * size, 0u);
+        for (uint32_t y = 0; y < size; ++y) {
+            for (uint32_t x = 0; x < size; ++x) words[y * wordsPerRow + x / 32] |= static_cast<uint32_t>(cells[static_cast<size_t>(y) * size + x]) << (x % 32);
+        }
+    }
+
+private:
+    uint32_t size;
+    Rule rule;
+    Boundary boundary;
+    std::vector<uint8_t> cells;
+};
+
+// Kernel under test, bitpacked cells in and out like CpuLife::copyCells and Life::readCells
+struct Engine {
+    std::function<void(const std::vector<uint32_t>&)> setCells;
+    std::function<void(uint64_t)> step;
+    std::function<void(std::vector<uint32_t>&)> readCells;
+};
+
+struct Scenario {
+    std::string name;
+    std::vector<uint32_t> words;
+};
+
+template <typename T>
+static std::vector<T> parseList(const std::string& text, const std::function<T(const std::string&)>& parse)
+{
+    std::vector<T> values;
+    std::stringstream stream(text);
+    std::string item;
+    while (std::getline(stream, item, ',')) values.push_back(parse(item));
+    if (values.empty()) throw std::invalid_argument("Empty list " + text);
+    return values;
+}
+
+static Options parseOptions(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--engines" && hasValue) {
+            options.engines = parseList<std::string>(argv[++i], [](const std::string& item) { return item; });
+        } else if (arg == "--sizes" && hasValue) {
+            options.sizes = parseList<uint32_t>(argv[++i], [](const std::string& item) {
+                const uint32_t size = static_cast<uint32_t>(std::stoul(item));
+                if (size == 0 || size % 32 != 0) throw std::invalid_argument("Grid sizes must be multiples of 32, got " + item);
+                return size;
+            });
+        } else if (arg == "--rules" && hasValue) {
+            options.rules = parseList<Rule>(argv[++i], [](const std::string& item) { return Rule::parse(item); });
+        } else if (arg == "--generations" && hasValue) {
+            options.generations = std::stoull(argv[++i]);
+        } else if (arg == "--check-every" && hasValue) {
+            options.checkInterval = std::max(1u, static_cast<uint32_t>(std::stoul(argv[++i])));
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--workgroup" && hasValue) {
+            options.workgroupSize = static_cast<uint32_t>(std::stoul(argv[++i]));
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = std::stoull(argv[++i]);
+        } else if (arg == "--software") {
+            options.software = true;
+        } else {
+            throw std::invalid_argument("Unknown or incomplete option " + arg);
+        }
+    }
+    return options;
+}
+
+// Pattern rows run top down like Pattern, the last row lands on y. Cells wrap around the grid
+static void stamp(std::vector<uint32_t>& words, uint32_t size, int64_t x, int64_t y, const std::vector<std::string>& rows)
+{
+    const int64_t n = size;
+    for (size_t row = 0; row < rows.size(); ++row) {
+        for (size_t column = 0; column < rows[row].size(); ++column) {
+            if (rows[row][column] != 'O') continue;
+            const int64_t cellX = (((x + static_cast<int64_t>(column)) % n) + n) % n;
+            const int64_t cellY = (((y + static_cast<int64_t>(rows.size() - 1 - row)) % n) + n) % n;
+            words[static_cast<size_t>(cellY) * (size / 32) + cellX / 32] |= 1u << (cellX % 32);
+        }
+    }
+}
+
+static std::vector<Scenario> makeScenarios(uint32_t size, uint64_t seed)
+{
+    const size_t wordCount = static_cast<size_t>(size / 32) * size;
+    std::vector<Scenario> scenarios;
+
+    // Soups from empty to full, the extremes hit every birth and survival count at once
+    for (double density : { 0.0, 0.03, 0.2, 0.5, 0.8, 0.97, 1.0 }) {
+        Scenario soup { "soup " + std::to_string(static_cast<int>(density * 100)) + "%", std::vector<uint32_t>(wordCount) };
+        std::mt19937_64 random(seed);
+        std::bernoulli_distribution active(density);
+        for (size_t i = 0; i < wordCount * 32; ++i) if (active(random)) soup.words[i / 32] |= 1u << (i % 32);
+        scenarios.push_back(std::move(soup));
+    }
+
+    const std::vector<std::string> glider { ".O.", "..O", "OOO" };
+    const std::vector<std::string> lwss { ".O..O", "O....", "O...O", "OOOO." };
+    const std::vector<std::string> blinker { "OOO" };
+    const int64_t n = size;
+
+    Scenario corner { "gliders across the corners", std::vector<uint32_t>(wordCount) };
+    stamp(corner.words, size, n - 2, n - 2, glider);
+    stamp(corner.words, size, -1, n / 2 - 1, glider);
+    stamp(corner.words, size, n / 2, -1, glider);
+    scenarios.push_back(std::move(corner));
+
+    Scenario edges { "spaceships across the edges", std::vector<uint32_t>(wordCount) };
+    stamp(edges.words, size, n - 3, n / 4, lwss);
+    stamp(edges.words, size, n / 4, n - 2, { "OOO.", "O...", ".O.." });
+    scenarios.push_back(std::move(edges));
+
+    // Bitpacked kernels shift across word boundaries, CPU bands split rows, GPU workgroups tile both
+    Scenario seams { "patterns on word and tile seams", std::vector<uint32_t>(wordCount) };
+    for (int64_t x = 30; x < n; x += 32) {
+        stamp(seams.words, size, x, (x * 7) % n, blinker);
+        stamp(seams.words, size, x + 1, (x * 13 + 8) % n, glider);
+    }
+    for (int64_t y = 6; y < n; y += 8) stamp(seams.words, size, (y * 5) % n, y, { "O", "O", "O" });
+    scenarios.push_back(std::move(seams));
+
+    Scenario stripes { "vertical stripes", std::vector<uint32_t>(wordCount, 0x55555555u) };
+    scenarios.push_back(std::move(stripes));
+    Scenario rows { "horizontal stripes", std::vector<uint32_t>(wordCount) };
+    for (uint32_t y = 0; y < size; y += 2) std::fill_n(rows.words.begin() + y * (size / 32), size / 32, 0xFFFFFFFFu);
+    scenarios.push_back(std::move(rows));
+    Scenario checkerboard { "checkerboard", std::vector<uint32_t>(wordCount) };
+    for (uint32_t y = 0; y < size; ++y) std::fill_n(checkerboard.words.begin() + y * (size / 32), size / 32, y % 2 ? 0xAAAAAAAAu : 0x55555555u);
+    scenarios.push_back(std::move(checkerboard));
+    return scenarios;
+}
+
+static std::unique_ptr<CpuLife> createCpuEngine(const Options& options, const std::string& name, uint32_t size,
+                                                Rule rule, Boundary boundary, Engine& engine)
+{
+    CpuLife::Config config;
+    config.width = size;
+    config.height = size;
+    config.rule = rule;
+    config.boundary = boundary;
+    config.threads = name == "cpu-threaded" ? options.threads : 1;
+    config.kernel = name == "cpu-swar32" ? CpuLife::Kernel::Swar32 : CpuLife::Kernel::Vector;
+    auto life = std::make_unique<CpuLife>(config);
+    CpuLife* cpu = life.get();
+    engine.setCells = [cpu](const std::vector<uint32_t>& words) { cpu->setCells(words.data(), 0); };
+    engine.step = [cpu](uint64_t generations) { cpu->step(static_cast<uint32_t>(generations)); };
+    engine.readCells = [cpu](std::vector<uint32_t>& words) {
+        words.resize(static_cast<size_t>(cpu->getWidth() / 32) * cpu->getHeight());
+        cpu->copyCells(words.data());
+    };
+    return life;
+}
+
+static std::unique_ptr<Life> createGpuEngine(const Options& options, const std::string& name, uint32_t size,
+                                             Rule rule, Boundary boundary, Engine& engine)
+{
+    Life::Config config;
+    config.gridSize = size;
+    config.rule = rule;
+    config.boundary = boundary;
+    config.packing = name == "gpu-bits" ? Life::Packing::Bits : Life::Packing::U32;
+    config.workgroupSize = options.workgroupSize;
+    config.seed = options.seed;
+    config.headless = true;
+    config.frameWidth = 1;
+    config.frameHeight = 1;
+    config.historyBudget = 0;
+    config.forceFallbackAdapter = options.software;
+    auto life = std::make_unique<Life>(config);
+    life->waitUntilReady();
+    Life* gpu = life.get();
+    engine.setCells = [gpu](const std::vector<uint32_t>& words) { gpu->setCells(words.data(), 0); };
+    engine.step = [gpu](uint64_t generations) { gpu->simulate(generations); };
+    engine.readCells = [gpu](std::vector<uint32_t>& words) { gpu->readCells(words); };
+    return life;
+}
+
+// An engine's first divergence from the reference, empty while it matches
+static std::string compare(const std::vector<uint32_t>& expected, const std::vector<uint32_t>& actual, uint32_t size,
+                           uint64_t generation, uint64_t interval)
+{
+    if (actual.size() != expected.size()) {
+        return "diverged at generation " + std::to_string(generation) + ", read back " + std::to_string(actual.size())
+            + " words instead of " + std::to_string(expected.size());
+    }
+    const uint32_t wordsPerRow = size / 32;
+    for (size_t i = 0; i < expected.size(); ++i) {
+        const uint32_t difference = expected[i] ^ actual[i];
+        if (difference == 0) continue;
+        const uint32_t x = static_cast<uint32_t>(i % wordsPerRow) * 32 + std::countr_zero(difference);
+        const uint32_t y = static_cast<uint32_t>(i / wordsPerRow);
+        const uint32_t want = (expected[i] >> (x % 32)) & 1u;
+        std::ostringstream report;
+        report << "diverged at generation " << generation;
+        if (interval > 1) report << " (checked every " << interval << ")";
+        report << ", cell (" << x << ", " << y << "): expected " << want << ", got " << (1u - want);
+        return report.str();
+    }
+    return {};
+}
+
+int main(int argc, char** argv) {
+    try {
+        const Options options = parseOptions(argc, argv);
+        for (const std::string& name : options.engines) {
+            if (name != "cpu-swar32" && name != "cpu-vector" && name != "cpu-threaded" && name != "gpu-u32" && name != "gpu-bits") {
+                throw std::invalid_argument("Unknown engine " + name);
+            }
+        }
+
+        uint64_t runs = 0;
+        uint64_t diverged = 0;
+        uint64_t unavailable = 0; // Engines that failed to start
+        for (uint32_t size : options.sizes) {
+            const std::vector<Scenario> scenarios = makeScenarios(size, options.seed);
+            for (const Rule& rule : options.rules) {
+                for (Boundary boundary : { Boundary::Torus, Boundary::Dead }) {
+                    const std::string config = std::to_string(size) + "x" + std::to_string(size) + " " + rule.toString()
+                        + (boundary == Boundary::Torus ? " torus" : " dead edges");
+
+                    // Every engine steps in lockstep with one reference run per scenario
+                    std::vector<std::string> names;
+                    std::vector<Engine> engines;
+                    std::vector<std::unique_ptr<CpuLife>> cpuEngines;
+                    std::vector<std::unique_ptr<Life>> gpuEngines;
+                    for (const std::string& name : options.engines) {
+                        Engine engine;
+                        try {
+                            if (name.starts_with("gpu")) gpuEngines.push_back(createGpuEngine(options, name, size, rule, boundary, engine));
+                            else cpuEngines.push_back(createCpuEngine(options, name, size, rule, boundary, engine));
+                        } catch (const std::exception& e) {
+                            std::cout << "FAIL " << name << " " << config << ": " << e.what() << std::endl;
+                            ++unavailable;
+                            continue;
+                        }
+                        names.push_back(name);
+                        engines.push_back(std::move(engine));
+                    }
+
+                    std::vector<bool> identical(engines.size(), true);
+                    for (const Scenario& scenario : scenarios) {
+                        ReferenceLife reference(size, rule, boundary);
+                        reference.setCells(scenario.words);
+                        for (Engine& engine : engines) engine.setCells(scenario.words);
+                        std::vector<std::string> divergences(engines.size());
+
+                        std::vector<uint32_t> expected;
+                        std::vector<uint32_t> actual;
+                        uint64_t generation = 0;
+                        while (generation < options.generations) {
+                            const uint64_t count = std::min<uint64_t>(options.checkInterval, options.generations - generation);
+                            for (uint64_t i = 0; i < count; ++i) reference.step();
+                            generation += count;
+                            reference.copyCells(expected);
+                            bool anyMatching = false;
+                            for (size_t e = 0; e < engines.size(); ++e) {
+                                if (!divergences[e].empty()) continue;
+                                engines[e].step(count);
+                                engines[e].readCells(actual);
+                                divergences[e] = compare(expected, actual, size, generation, count);
+                                anyMatching |= divergences[e].empty();
+                            }
+                            if (!anyMatching) break;
+                        }
+
+                        for (size_t e = 0; e < engines.size(); ++e) {
+                            ++runs;
+                            if (divergences[e].empty()) continue;
+                            std::cout << "FAIL " << names[e] << " " << config << ", " << scenario.name << ": " << divergences[e] << std::endl;
+                            ++diverged;
+                            identical[e] = false;
+                        }
+                    }
+                    for (size_t e = 0; e < engines.size(); ++e) if (identical[e]) std::cout << "ok   " << names[e] << " " << config << std::endl;
+                }
+            }
+        }
+        std::cout << runs - diverged << " of " << runs << " runs bit-identical to the reference over "
+                  << options.generations << " generations";
+        if (unavailable > 0) std::cout << ", " << unavailable << " engines failed to start";
+        std::cout << std::endl;
+        if (diverged > 0 || unavailable > 0) return 1;
+    } catch(const std::exception& e) {
+        std::cerr << "Fatal error: " << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
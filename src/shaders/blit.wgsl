@@ -0,0 +1,38 @@
+// ======================================================
+// Bindings
+// ======================================================
+// Low resolution frame the cells were rendered into (Life::offscreenTexture)
+@group(0) @binding(0) var frame: texture_2d<f32>;
+
+// ======================================================
+// Vertex Shader Output Struct
+// ======================================================
+struct VertexOutput {
+  @builtin(position) pos: vec4f, // Clip space position, must be returned to GPU
+  @location(0) uv: vec2f, // Texture coordinate, (0,0) at the top left of the frame
+};
+
+// ======================================================
+// Vertex Shader
+// ======================================================
+@vertex
+// Draws a single triangle covering the whole surface, no vertex buffer needed
+fn vertexMain(@builtin(vertex_index) index: u32) -> VertexOutput {
+  let corner = vec2f(f32((index << 1) & 2), f32(index & 2)); // (0,0), (2,0), (0,2)
+
+  var output: VertexOutput;
+  output.pos = vec4f(corner * 2 - 1, 0, 1);
+  output.uv = vec2f(corner.x, 1 - corner.y); // Clip space y points up, texture y points down
+  return output;
+}
+
+// ======================================================
+// Fragment Shader
+// ======================================================
+@fragment
+// Nearest-neighbor upscale, each surface pixel copies the texel it falls in
+fn fragmentMain(input: VertexOutput) -> @location(0) vec4f {
+  let size = textureDimensions(frame);
+  let texel = min(vec2u(input.uv * vec2f(size)), size - 1);
+  return textureLoad(frame, texel, 0);
+}
@@ -0,0 +1,66 @@
+// ======================================================
+// Cell Storage Helpers
+// ======================================================
+// Shared by every shader that touches cell state. The includer declares `grid` and `cellStateIn`
+// (WGSL can't pass storage arrays to functions), and the variant constants from shader.wgsl
+
+#ifndef PACKED_BITS
+#define PACKED_BITS 0
+#endif
+#ifndef BOUNDARY_TORUS
+#define BOUNDARY_TORUS 1
+#endif
+
+fn gridWidth() -> i32 {
+  return i32(grid.x);
+}
+
+fn gridHeight() -> i32 {
+  return i32(grid.y);
+}
+
+#if PACKED_BITS
+// 32 cells per word along x, bit i of word w holds cell x = w * 32 + i
+// Rows always start on a word boundary (Life requires the width to be a multiple of 32)
+fn wordsPerRow() -> i32 {
+  return gridWidth() / 32;
+}
+
+// Word wx of row y, 0 outside the grid unless BOUNDARY_TORUS wraps it back in
+fn loadWord(wx: i32, y: i32) -> u32 {
+#if BOUNDARY_TORUS
+  let x = (wx + wordsPerRow()) % wordsPerRow();
+  let row = (y + gridHeight()) % gridHeight();
+  return cellStateIn[u32(row * wordsPerRow() + x)];
+#else
+  if (wx < 0 || wx >= wordsPerRow() || y < 0 || y >= gridHeight()) {
+    return 0u;
+  }
+  return cellStateIn[u32(y * wordsPerRow() + wx)];
+#endif
+}
+
+// Active state (0 or 1) of the cell at (x, y) inside the grid
+fn cellState(x: u32, y: u32) -> u32 {
+  return (cellStateIn[y * u32(wordsPerRow()) + x / 32u] >> (x % 32u)) & 1u;
+}
+#else
+// Active state (0 or 1) of the cell at (x, y), 0 outside the grid unless BOUNDARY_TORUS wraps it back in
+fn cellActive(x: i32, y: i32) -> u32 {
+#if BOUNDARY_TORUS
+  let column = (x + gridWidth()) % gridWidth();
+  let row = (y + gridHeight()) % gridHeight();
+  return cellStateIn[u32(row * gridWidth() + column)];
+#else
+  if (x < 0 || x >= gridWidth() || y < 0 || y >= gridHeight()) {
+    return 0u;
+  }
+  return cellStateIn[u32(y * gridWidth() + x)];
+#endif
+}
+
+// Active state (0 or 1) of the cell at (x, y) inside the grid
+fn cellState(x: u32, y: u32) -> u32 {
+  return cellStateIn[y * u32(gridWidth()) + x];
+}
+#endif
@@ -0,0 +1,33 @@
+// ======================================================
+// Bindings
+// ======================================================
+// The grid dimensions, the same uniform as shader.wgsl
+@group(0) @binding(0) var<uniform> grid: vec2f;
+
+// Generation being read back, one cell per u32 (a slot of Life::CellBufferRing)
+@group(0) @binding(1) var<storage> cells: array<u32>;
+
+// The same generation bitpacked: bit i of word w holds cell x = w * 32 + i, every row starts on a word
+@group(0) @binding(2) var<storage, read_write> words: array<u32>;
+
+// ======================================================
+// Compute Shader
+// ======================================================
+// Each invocation packs one word of a row, so readbacks move 32 times fewer bytes than the state
+@compute
+@workgroup_size(8, 8)
+fn computeMain(@builtin(global_invocation_id) id: vec3u) {
+  let width = u32(grid.x);
+  let wordsPerRow = (width + 31u) / 32u;
+  if (id.x >= wordsPerRow || id.y >= u32(grid.y)) {
+    return;
+  }
+
+  let first = id.y * width + id.x * 32u;
+  let count = min(32u, width - id.x * 32u);
+  var word = 0u;
+  for (var bit = 0u; bit < count; bit++) {
+    word |= (cells[first + bit] & 1u) << bit;
+  }
+  words[id.y * wordsPerRow + id.x] = word;
+}
@@ -0,0 +1,48 @@
+// ======================================================
+// Counter-Based Random Cells
+// ======================================================
+// Stateless, every word is a pure function of (key, group, row, level), so any part of the grid
+// can be generated in any order on any number of invocations and always comes out the same.
+
+// Integer hash with full avalanche (lowbias32 by Chris Wellons), constant shifts only
+fn hash32(value: u32) -> u32 {
+  var x = value;
+  x ^= x >> 16u;
+  x *= 0x7feb352du;
+  x ^= x >> 15u;
+  x *= 0x846ca68bu;
+  x ^= x >> 16u;
+  return x;
+}
+
+// Per row and density level. The row goes in first and both key halves after it, so two seeds would
+// have to collide on every row at once to repeat a soup, and the rows of one seed never share a salt
+fn rowSalt(key: vec2u, row: u32, level: u32) -> u32 {
+  return hash32(key.y ^ hash32(key.x ^ hash32(row ^ hash32(level))));
+}
+
+// 32 uniform random bits for one density level of one group of 32 cells. The group is hashed on its
+// own and XORed in rather than added to the salt, so rows whose salts differ by a few groups don't
+// come out as shifted copies of each other
+fn randomWord(key: vec2u, mixedGroup: u32, row: u32, level: u32) -> u32 {
+  return hash32(mixedGroup ^ rowSalt(key, row, level));
+}
+
+// 32 cells, each active with probability threshold / 256. Walks the binary expansion of the
+// density from its lowest set bit up: a 1 bit ORs in a fresh random word (p = 1/2 + p/2),
+// a 0 bit ANDs one in (p = p/2), so the result is exact with at most 8 random words
+fn randomCells(key: vec2u, group: u32, row: u32, threshold: u32) -> u32 {
+  if (threshold >= 256u) {
+    return 0xFFFFFFFFu;
+  }
+  if (threshold == 0u) {
+    return 0u;
+  }
+  var result = 0u;
+  let mixedGroup = hash32(group);
+  for (var bit = countTrailingZeros(threshold); bit < 8u; bit++) {
+    let word = randomWord(key, mixedGroup, row, bit);
+    result = select(result & word, result | word, ((threshold >> bit) & 1u) == 1u);
+  }
+  return result;
+}
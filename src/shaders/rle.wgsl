@@ -0,0 +1,179 @@
+// ======================================================
+// Variant Constants
+// ======================================================
+// PACKED_BITS  1 stores 32 cells per u32 along x, 0 stores one cell per u32 (see grid.wgsl)
+#ifndef PACKED_BITS
+#define PACKED_BITS 0
+#endif
+
+// ======================================================
+// Bindings
+// ======================================================
+// Written by RleCodec, see RleCodec::RleParams. Runs cover the cells in row-major order from the top
+// row down (grid y points up), alternating dead and live starting with dead
+struct RleParams {
+  origin: vec2u,    // Decode: grid cell of the bottom left corner of the pattern
+  size: vec2u,      // Decode: pattern width and height
+  visible: vec2u,   // Decode: pattern columns and rows inside the grid
+  gridSize: u32,    // Cells per side
+  runCount: u32,    // Decode: number of runs
+};
+@group(0) @binding(0) var<uniform> params: RleParams;
+
+// Generation being decoded into or encoded (a slot of Life::CellBufferRing)
+@group(0) @binding(1) var<storage, read_write> cells: array<u32>;
+
+// Decode: run lengths and their exclusive prefix sums (runCount + 1 entries), from scan.wgsl
+// Encode: run boundaries in each group of 32 cells and their exclusive prefix sums
+@group(0) @binding(2) var<storage, read_write> counts: array<u32>;
+@group(0) @binding(3) var<storage, read_write> offsets: array<u32>;
+
+// Encode: index of every cell that starts a run, in run order
+@group(0) @binding(4) var<storage, read_write> boundaries: array<u32>;
+
+// ======================================================
+// Cell Groups
+// ======================================================
+fn wordsPerRow() -> u32 {
+  return (params.gridSize + 31u) / 32u;
+}
+
+// Bits [lo, hi) set, hi <= 32
+fn bitRange(lo: u32, hi: u32) -> u32 {
+  return select((1u << hi) - 1u, 0xFFFFFFFFu, hi == 32u) & ~((1u << lo) - 1u);
+}
+
+fn cellAt(x: u32, y: u32) -> u32 {
+#if PACKED_BITS
+  return (cells[y * wordsPerRow() + x / 32u] >> (x % 32u)) & 1u;
+#else
+  return cells[y * params.gridSize + x];
+#endif
+}
+
+// Cells group * 32 to group * 32 + 31 of row y, bit i is cell group * 32 + i (0 past the grid edge)
+fn loadGroup(group: u32, y: u32) -> u32 {
+#if PACKED_BITS
+  return cells[y * wordsPerRow() + group];
+#else
+  let first = group * 32u;
+  let count = min(32u, params.gridSize - first);
+  var word = 0u;
+  for (var bit = 0u; bit < count; bit++) {
+    word |= cells[y * params.gridSize + first + bit] << bit;
+  }
+  return word;
+#endif
+}
+
+// Replaces the cells of the group selected by mask
+fn storeGroup(group: u32, y: u32, word: u32, mask: u32) {
+#if PACKED_BITS
+  let index = y * wordsPerRow() + group;
+  cells[index] = (cells[index] & ~mask) | (word & mask);
+#else
+  for (var bit = 0u; bit < 32u; bit++) {
+    if (((mask >> bit) & 1u) == 1u) {
+      cells[y * params.gridSize + group * 32u + bit] = (word >> bit) & 1u;
+    }
+  }
+#endif
+}
+
+// ======================================================
+// Decode
+// ======================================================
+// One invocation per group of 32 grid cells the pattern covers. The prefix sums place every run, so
+// each group binary searches the first run that reaches it and walks the (at most 33) runs inside it
+@compute
+@workgroup_size(8, 8)
+fn decodeMain(@builtin(global_invocation_id) id: vec3u) {
+  if (id.y >= params.visible.y) {
+    return;
+  }
+  let y = params.origin.y + id.y;
+  let row = params.size.y - 1u - id.y;
+  let group = params.origin.x / 32u + id.x;
+  let firstX = group * 32u;
+  let endX = params.origin.x + params.visible.x;
+  if (firstX >= endX) {
+    return;
+  }
+
+  // Bits of the group inside the pattern, and the cells they hold in run order
+  let lo = max(firstX, params.origin.x) - firstX;
+  let hi = min(firstX + 32u, endX) - firstX;
+  let begin = row * params.size.x + (firstX + lo - params.origin.x);
+  let end = begin + (hi - lo);
+
+  var low = 0u;
+  var high = params.runCount;
+  while (high - low > 1u) {
+    let middle = (low + high) / 2u;
+    if (offsets[middle] <= begin) {
+      low = middle;
+    } else {
+      high = middle;
+    }
+  }
+
+  var word = 0u;
+  for (var run = low; run < params.runCount && offsets[run] < end; run++) {
+    // Odd runs are live
+    if ((run & 1u) == 1u) {
+      let first = max(offsets[run], begin);
+      let last = min(offsets[run + 1u], end);
+      if (first < last) {
+        word |= bitRange(first - begin + lo, last - begin + lo);
+      }
+    }
+  }
+  storeGroup(group, y, word, bitRange(lo, hi));
+}
+
+// ======================================================
+// Encode
+// ======================================================
+// A run starts wherever a cell differs from the one before it in run order (the first cell is
+// compared against a dead one). id.x is the group in the row, id.y the row counted from the top
+fn runStarts(group: u32, row: u32) -> u32 {
+  let y = params.gridSize - 1u - row;
+  let word = loadGroup(group, y);
+  var previous = 0u;
+  if (group > 0u) {
+    previous = cellAt(group * 32u - 1u, y);
+  } else if (row > 0u) {
+    previous = cellAt(params.gridSize - 1u, y + 1u);
+  }
+  let valid = bitRange(0u, min(32u, params.gridSize - group * 32u));
+  return (word ^ ((word << 1u) | previous)) & valid;
+}
+
+fn inGrid(id: vec3u) -> bool {
+  return id.x < wordsPerRow() && id.y < params.gridSize;
+}
+
+@compute
+@workgroup_size(8, 8)
+fn countMain(@builtin(global_invocation_id) id: vec3u) {
+  if (!inGrid(id)) {
+    return;
+  }
+  counts[id.y * wordsPerRow() + id.x] = countOneBits(runStarts(id.x, id.y));
+}
+
+@compute
+@workgroup_size(8, 8)
+fn emitMain(@builtin(global_invocation_id) id: vec3u) {
+  if (!inGrid(id)) {
+    return;
+  }
+  var starts = runStarts(id.x, id.y);
+  var index = offsets[id.y * wordsPerRow() + id.x];
+  let base = id.y * params.gridSize + id.x * 32u;
+  while (starts != 0u) {
+    boundaries[index] = base + countTrailingZeros(starts);
+    index++;
+    starts &= starts - 1u;
+  }
+}
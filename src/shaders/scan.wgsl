@@ -0,0 +1,124 @@
+// ======================================================
+// Bindings
+// ======================================================
+// Written by RleCodec::recordScan, see RleCodec::ScanParams
+struct ScanParams {
+  count: u32,       // Number of values
+  blockCount: u32,  // Blocks of BLOCK_SIZE values, one workgroup each
+  _pad0: u32,
+  _pad1: u32,
+};
+@group(0) @binding(0) var<uniform> params: ScanParams;
+
+@group(0) @binding(1) var<storage, read> values: array<u32>;
+// Exclusive prefix sums of values, count + 1 entries so the last one holds the total
+@group(0) @binding(2) var<storage, read_write> sums: array<u32>;
+// Per block totals, scanned in place by spineMain
+@group(0) @binding(3) var<storage, read_write> blockSums: array<u32>;
+
+// ======================================================
+// Workgroup Scan
+// ======================================================
+// Three passes over blocks of BLOCK_SIZE values: reduceMain totals every block, spineMain scans the
+// totals on a single workgroup, downsweepMain scans each block again starting from its total.
+// Blocks are spread over a 2D dispatch, so counts beyond 65535 workgroups still fit
+const SCAN_WORKGROUP_SIZE = 256u;
+const ITEMS_PER_INVOCATION = 4u;
+const BLOCK_SIZE = 1024u;
+
+var<workgroup> partials: array<u32, SCAN_WORKGROUP_SIZE>;
+
+// Inclusive scan of one value per invocation (Hillis-Steele)
+fn workgroupInclusiveScan(localIndex: u32, value: u32) -> u32 {
+  partials[localIndex] = value;
+  workgroupBarrier();
+  for (var offset = 1u; offset < SCAN_WORKGROUP_SIZE; offset <<= 1u) {
+    var add = 0u;
+    if (localIndex >= offset) {
+      add = partials[localIndex - offset];
+    }
+    workgroupBarrier();
+    partials[localIndex] += add;
+    workgroupBarrier();
+  }
+  return partials[localIndex];
+}
+
+fn valueAt(index: u32) -> u32 {
+  if (index >= params.count) {
+    return 0u;
+  }
+  return values[index];
+}
+
+fn blockIndex(group: vec3u, groups: vec3u) -> u32 {
+  return group.y * groups.x + group.x;
+}
+
+// ======================================================
+// Compute Shaders
+// ======================================================
+@compute
+@workgroup_size(SCAN_WORKGROUP_SIZE)
+fn reduceMain(@builtin(workgroup_id) group: vec3u, @builtin(num_workgroups) groups: vec3u,
+              @builtin(local_invocation_index) localIndex: u32) {
+  let block = blockIndex(group, groups);
+  if (block >= params.blockCount) {
+    return;
+  }
+  let first = block * BLOCK_SIZE + localIndex * ITEMS_PER_INVOCATION;
+  var total = 0u;
+  for (var i = 0u; i < ITEMS_PER_INVOCATION; i++) {
+    total += valueAt(first + i);
+  }
+  let scanned = workgroupInclusiveScan(localIndex, total);
+  if (localIndex == SCAN_WORKGROUP_SIZE - 1u) {
+    blockSums[block] = scanned;
+  }
+}
+
+@compute
+@workgroup_size(SCAN_WORKGROUP_SIZE)
+fn spineMain(@builtin(local_invocation_index) localIndex: u32) {
+  // Each invocation owns a contiguous run of block totals
+  let perInvocation = (params.blockCount + SCAN_WORKGROUP_SIZE - 1u) / SCAN_WORKGROUP_SIZE;
+  let first = localIndex * perInvocation;
+  let last = min(first + perInvocation, params.blockCount);
+  var total = 0u;
+  for (var i = first; i < last; i++) {
+    total += blockSums[i];
+  }
+  var running = workgroupInclusiveScan(localIndex, total) - total;
+  for (var i = first; i < last; i++) {
+    let value = blockSums[i];
+    blockSums[i] = running;
+    running += value;
+  }
+  if (localIndex == SCAN_WORKGROUP_SIZE - 1u) {
+    sums[params.count] = running;
+  }
+}
+
+@compute
+@workgroup_size(SCAN_WORKGROUP_SIZE)
+fn downsweepMain(@builtin(workgroup_id) group: vec3u, @builtin(num_workgroups) groups: vec3u,
+                 @builtin(local_invocation_index) localIndex: u32) {
+  let block = blockIndex(group, groups);
+  if (block >= params.blockCount) {
+    return;
+  }
+  let first = block * BLOCK_SIZE + localIndex * ITEMS_PER_INVOCATION;
+  var items: array<u32, ITEMS_PER_INVOCATION>;
+  var total = 0u;
+  for (var i = 0u; i < ITEMS_PER_INVOCATION; i++) {
+    items[i] = valueAt(first + i);
+    total += items[i];
+  }
+  var running = blockSums[block] + workgroupInclusiveScan(localIndex, total) - total;
+  for (var i = 0u; i < ITEMS_PER_INVOCATION; i++) {
+    if (first + i < params.count) {
+      sums[first + i] = running;
+    }
+    running += items[i];
+  }
+}
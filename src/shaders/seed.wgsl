@@ -0,0 +1,59 @@
+// ======================================================
+// Variant Constants
+// ======================================================
+// PACKED_BITS  1 stores 32 cells per u32 along x, 0 stores one cell per u32 (see grid.wgsl)
+#ifndef PACKED_BITS
+#define PACKED_BITS 0
+#endif
+
+// ======================================================
+// Bindings
+// ======================================================
+// Written by Life::seed, see Life::SeedParams
+struct SeedParams {
+  key: vec2u,       // Random::key of the 64 bit seed, low word first
+  rectMin: vec2u,   // First cell of the seeded rectangle
+  rectMax: vec2u,   // One past its last cell
+  width: u32,       // Grid width in cells
+  threshold: u32,   // Density in 1/256 steps, 256 makes every cell active
+};
+@group(0) @binding(0) var<uniform> params: SeedParams;
+
+// Generation being seeded (a slot of Life::CellBufferRing)
+@group(0) @binding(1) var<storage, read_write> cells: array<u32>;
+
+#include "random.wgsl"
+
+// ======================================================
+// Compute Shader
+// ======================================================
+// Each invocation seeds one group of 32 cells along x (one word when bitpacked), so both packings
+// produce the same soup from the same seed. Cells outside the rectangle are left as they are
+@compute
+@workgroup_size(8, 8)
+fn computeMain(@builtin(global_invocation_id) id: vec3u) {
+  let group = id.x;
+  let y = params.rectMin.y + id.y;
+  let firstX = group * 32u;
+  if (y >= params.rectMax.y || firstX >= params.width) {
+    return;
+  }
+
+  // Bits of the group inside the rectangle
+  let lo = max(params.rectMin.x, firstX) - firstX;
+  let hi = min(params.rectMax.x, firstX + 32u) - firstX;
+  if (lo >= hi) {
+    return;
+  }
+  let mask = select((1u << hi) - 1u, 0xFFFFFFFFu, hi == 32u) & ~((1u << lo) - 1u);
+  let word = randomCells(params.key, group, y, params.threshold);
+
+#if PACKED_BITS
+  let index = y * ((params.width + 31u) / 32u) + group;
+  cells[index] = (cells[index] & ~mask) | (word & mask);
+#else
+  for (var bit = lo; bit < hi; bit++) {
+    cells[y * params.width + firstX + bit] = (word >> bit) & 1u;
+  }
+#endif
+}
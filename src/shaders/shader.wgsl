@@ -1,47 +1,61 @@
+// ======================================================
+// Variant Constants
+// ======================================================
+// Set by Shader::preprocess from Life::shaderDefines, so every variant is constant-folded
+// WORKGROUP_SIZE  Compute tile edge, a workgroup covers WORKGROUP_SIZE x WORKGROUP_SIZE cells (or words)
+// BIRTH_MASK      Bit n set when an inactive cell with n active neighbors becomes active (B3 = 0x8u)
+// SURVIVE_MASK    Bit n set when an active cell with n active neighbors stays active (S23 = 0xCu)
+// BOUNDARY_TORUS  1 connects opposite edges, 0 treats cells beyond the edges as inactive
+// PACKED_BITS     1 stores 32 cells per u32 along x, 0 stores one cell per u32
+#ifndef WORKGROUP_SIZE
+#define WORKGROUP_SIZE 8u
+#endif
+#ifndef BIRTH_MASK
+#define BIRTH_MASK 0x8u
+#endif
+#ifndef SURVIVE_MASK
+#define SURVIVE_MASK 0xCu
+#endif
+
 // ======================================================
 // Bindings
 // ======================================================
-// The grid dimensions ex. [256, 256] for 256x256 size grid (Life::GRID_DIMENSIONS)
-@group(0) @binding(0) var<uniform> grid: vec2f; 
+// The grid dimensions ex. [256, 256] for 256x256 size grid (Life::Config::gridSize)
+@group(0) @binding(0) var<uniform> grid: vec2f;
 
-// Cell state buffers (Alternative between Life::PingPongBuffers::read and ::write each frame)
-// Stored as u32 (not bool) for arithmetic convenience and storage buffer compatibility
-// This could be optimized with bitpacking and bitwise operations, but memory savings are negligible at low grid sizes
+// Cell state buffers (Consecutive slots of Life::CellBufferRing, advancing one slot each step)
+// The render pipeline only binds cellStateIn, pointing at the generation being displayed
+// Stored as u32 (not bool) for arithmetic convenience and storage buffer compatibility,
+// either one cell per u32 or bitpacked (PACKED_BITS)
 @group(0) @binding(1) var<storage> cellStateIn: array<u32>; // Current state
 @group(0) @binding(2) var<storage, read_write> cellStateOut: array<u32>; // Next state
 
+#include "grid.wgsl"
+
 // ======================================================
-// Vertex Shader Input/Output Structs
+// Vertex Shader Output Struct
 // ======================================================
-struct VertexInput {
-  @location(0) pos: vec2f, // Vertex (buffered from Life::vertexBuffer)
-  @builtin(instance_index) instance: u32, // Instance index (one for each vertex in each cell)
-};
 struct VertexOutput {
   @builtin(position) pos: vec4f, // Clip space position, must be returned to GPU
-  @location(0) cell: vec2f, // Cell position in grid, use in fragment shader
+  @location(0) gridPos: vec2f, // Position in cells, (0,0) at the bottom left corner of cell (0,0)
 };
 
+// Share of a cell's edge left empty on each side, so neighboring active cells stay apart
+const CELL_MARGIN = 0.1;
+
 // ======================================================
 // Vertex Shader
 // ======================================================
 @vertex
-fn vertexMain(input: VertexInput) -> VertexOutput  {
-  // Convert instance index to cell position
-  let i = f32(input.instance); // Get instance index as float
-  let cell = vec2f(i % grid.x, floor(i / grid.x)); // Convert to cell coordinates (x,y)
-
-  // Get cell state (0 or 1)
-  let state = f32(cellStateIn[input.instance]);
-
-  // Convert cell's grid position to clip space
-  let cellOffset = cell / grid * 2;
-  let gridPos = (input.pos * state + 1) / grid - 1 + cellOffset;
+// Draws a single triangle covering the whole target, no vertex buffer needed. Cells are looked up per
+// pixel, so the cost follows the target size rather than the cell count (a 65536x65536 grid has more
+// cells than an instanced draw can count)
+fn vertexMain(@builtin(vertex_index) index: u32) -> VertexOutput {
+  let corner = vec2f(f32((index << 1) & 2), f32(index & 2)); // (0,0), (2,0), (0,2)
 
-  // Return output to GPU
   var output: VertexOutput;
-  output.pos = vec4f(gridPos, 0, 1);
-  output.cell = cell;
+  output.pos = vec4f(corner * 2 - 1, 0, 1);
+  output.gridPos = corner * grid;
   return output;
 }
 
@@ -49,59 +63,116 @@ fn vertexMain(input: VertexInput) -> VertexOutput  {
 // Fragment Shader
 // ======================================================
 @fragment
-// Takes VertexOutput (see above) as fragment input
-// Runs for each pixel in each fragment in each cell
+// Runs for each pixel, inactive cells and the margins between cells keep the clear color
 fn fragmentMain(input: VertexOutput) -> @location(0) vec4f {
+  let cell = min(vec2u(input.gridPos), vec2u(grid) - 1u);
+  let inCell = input.gridPos - vec2f(cell);
+  if (any(inCell < vec2f(CELL_MARGIN)) || any(inCell > vec2f(1 - CELL_MARGIN)) || cellState(cell.x, cell.y) == 0u) {
+    discard;
+  }
+
   // Color based on cell position in grid (gradient effect calculated from x, y position)
-  let c = input.cell / grid;
+  let c = vec2f(cell) / grid;
   return vec4f(c.x, c.y, 1-c.x, 1);
 }
 
 // ======================================================
-// Compute Shader Helper Functions
+// Compute Shader
 // ======================================================
-fn cellIndex(cell: vec2u) -> u32 {
-  // Cells are stored in a 1D array, so converts 2D (x,y) to 1D index
-  // Wraps around edges using modulo operator, so opposite edges are connected
-  return (cell.y % u32(grid.y)) * u32(grid.x) +
-         (cell.x % u32(grid.x));
+#if PACKED_BITS
+// Neighbor words for a whole word of cells, bit i holds the cell to the west (x-1) or east (x+1) of bit i
+fn westOf(left: u32, center: u32) -> u32 {
+  return (center << 1u) | (left >> 31u);
+}
+fn eastOf(center: u32, right: u32) -> u32 {
+  return (center >> 1u) | (right << 31u);
 }
 
-fn cellActive(x: u32, y: u32) -> u32 {
-  // Gets cell active state (0 or 1) for index converted from (x,y)
-  return cellStateIn[cellIndex(vec2(x, y))];
+// All ones when bit n of the rule mask is set, so the rule is applied with masks instead of branches
+fn ruleBits(mask: u32, n: u32) -> u32 {
+  return 0u - ((mask >> n) & 1u);
 }
 
-// ======================================================
-// Compute Shader
-// ======================================================
+// Each invocation steps one word (32 cells) with bit-sliced addition of its 8 neighbor words
+@compute
+@workgroup_size(WORKGROUP_SIZE, WORKGROUP_SIZE)
+fn computeMain(@builtin(global_invocation_id) id: vec3u) {
+  let x = i32(id.x);
+  let y = i32(id.y);
+  if (x >= wordsPerRow() || y >= gridHeight()) {
+    return;
+  }
+
+  let aboveLeft = loadWord(x - 1, y - 1);
+  let above = loadWord(x, y - 1);
+  let aboveRight = loadWord(x + 1, y - 1);
+  let left = loadWord(x - 1, y);
+  let center = loadWord(x, y);
+  let right = loadWord(x + 1, y);
+  let belowLeft = loadWord(x - 1, y + 1);
+  let below = loadWord(x, y + 1);
+  let belowRight = loadWord(x + 1, y + 1);
+
+  let n0 = westOf(aboveLeft, above);
+  let n1 = above;
+  let n2 = eastOf(above, aboveRight);
+  let n3 = westOf(left, center);
+  let n4 = eastOf(center, right);
+  let n5 = westOf(belowLeft, below);
+  let n6 = below;
+  let n7 = eastOf(below, belowRight);
+
+  // Full adders reduce the 8 neighbor bits of every cell to a 4 bit count (bit0..bit3)
+  let sumA = n0 ^ n1 ^ n2;
+  let carryA = (n0 & n1) | (n2 & (n0 ^ n1));
+  let sumB = n3 ^ n4 ^ n5;
+  let carryB = (n3 & n4) | (n5 & (n3 ^ n4));
+  let sumC = n6 ^ n7;
+  let carryC = n6 & n7;
+
+  let bit0 = sumA ^ sumB ^ sumC;
+  let carryD = (sumA & sumB) | (sumC & (sumA ^ sumB));
+
+  let sumE = carryA ^ carryB ^ carryC;
+  let carryE = (carryA & carryB) | (carryC & (carryA ^ carryB));
+  let bit1 = sumE ^ carryD;
+  let carryF = sumE & carryD;
 
-// Default to 8, but dynamically overriden in compute pipeline
-override WORKGROUP_SIZE: u32 = 8;
+  let bit2 = carryE ^ carryF;
+  let bit3 = carryE & carryF;
 
+  // Compare the count against every n, the masks fold to constants per variant
+  var next = 0u;
+  for (var n = 0u; n <= 8u; n++) {
+    let equals = ~(bit0 ^ ruleBits(n, 0u)) & ~(bit1 ^ ruleBits(n, 1u)) &
+                 ~(bit2 ^ ruleBits(n, 2u)) & ~(bit3 ^ ruleBits(n, 3u));
+    next |= equals & ((center & ruleBits(SURVIVE_MASK, n)) | (~center & ruleBits(BIRTH_MASK, n)));
+  }
+  cellStateOut[u32(y * wordsPerRow() + x)] = next;
+}
+#else
 @compute
 @workgroup_size(WORKGROUP_SIZE, WORKGROUP_SIZE)
 fn computeMain(@builtin(global_invocation_id) cell: vec3u) {
-  // Count active neighbors
-  let activeNeighbors = cellActive(cell.x+1, cell.y+1) +
-                        cellActive(cell.x+1, cell.y) +
-                        cellActive(cell.x+1, cell.y-1) +
-                        cellActive(cell.x, cell.y-1) +
-                        cellActive(cell.x-1, cell.y-1) +
-                        cellActive(cell.x-1, cell.y) +
-                        cellActive(cell.x-1, cell.y+1) +
-                        cellActive(cell.x, cell.y+1);
-  // Apply Conway's Game of Life rules
-  let i = cellIndex(cell.xy);
-  switch activeNeighbors {
-    case 2: { // Active cells with 2 neighbors stay active.
-      cellStateOut[i] = cellStateIn[i];
-    }
-    case 3: { // Cells with 3 neighbors become or stay active.
-      cellStateOut[i] = 1;
-    }
-    default: { // Cells with < 2 or > 3 neighbors become inactive.
-      cellStateOut[i] = 0;
-    }
+  let x = i32(cell.x);
+  let y = i32(cell.y);
+  if (x >= gridWidth() || y >= gridHeight()) {
+    return;
   }
-}
\ No newline at end of file
+
+  // Count active neighbors
+  let activeNeighbors = cellActive(x+1, y+1) +
+                        cellActive(x+1, y) +
+                        cellActive(x+1, y-1) +
+                        cellActive(x, y-1) +
+                        cellActive(x-1, y-1) +
+                        cellActive(x-1, y) +
+                        cellActive(x-1, y+1) +
+                        cellActive(x, y+1);
+
+  // Apply the rule: bit activeNeighbors of the survive (active) or birth (inactive) mask
+  let i = u32(y * gridWidth() + x);
+  let rule = select(BIRTH_MASK, SURVIVE_MASK, cellStateIn[i] == 1u);
+  cellStateOut[i] = (rule >> activeNeighbors) & 1u;
+}
+#endif